@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
   
@@ -17,17 +18,82 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
-/* Number of timer ticks since OS booted. */
+/* 8254 input frequency, and its count for one timer tick,
+   rounded to nearest. */
+#define PIT_HZ 1193180
+#define PIT_TICK ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Number of timer ticks since OS booted.  Updated only by the
+   timer interrupt handler, under ticks_seq. */
 static int64_t ticks;
+static struct seqlock ticks_seq;
+
+/* Tickless idle.
+
+   If true, set by kernel command-line option "-nohz", the idle
+   thread stops the periodic tick and programs the PIT in one-shot
+   mode to interrupt at the next timer wheel deadline.  The ticks
+   that were skipped are replayed when the CPU wakes up, whether
+   by that interrupt or an earlier one, so `ticks' stays right.
+   PIT counts that do not add up to a whole tick are carried in
+   nohz_residue. */
+bool timer_nohz;
+static bool nohz_armed;         /* PIT in one-shot mode? */
+static unsigned nohz_count;     /* One-shot count programmed. */
+static unsigned nohz_residue;   /* PIT counts since the last tick. */
+
+/* Longest one-shot period, in ticks, that fits the 16-bit PIT
+   counter with room to tell a fired count from a running one. */
+#define NOHZ_MAX_TICKS (0xf000 / PIT_TICK)
+
+/* Statistics. */
+static long long nohz_idles;    /* # of tickless idle periods. */
+static long long nohz_replayed; /* # of ticks caught up on wakeup. */
+
+/* Hierarchical timer wheel.
+
+   Level L has WHEEL_SLOTS slots, each spanning
+   WHEEL_SLOTS**L ticks, so the whole wheel covers
+   WHEEL_SLOTS**WHEEL_LEVELS ticks ahead.  An event goes into
+   the lowest level whose range covers its deadline, so adding an
+   event is O(1).  Whenever the level 0 index wraps, the due slot
+   of the next level up is cascaded down, so each event is moved
+   at most WHEEL_LEVELS - 1 times before it fires.  Events further
+   out than the wheel covers wait in the last slot of the top
+   level and are re-placed as they cascade. */
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+static struct list wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+
+/* Last tick processed by the wheel.  Equal to `ticks' except
+   inside timer_interrupt(). */
+static int64_t wheel_time;
 
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* TSC clock source.  tsc_hz is the TSC frequency, measured
+   against the PIT by timer_calibrate(), and tsc_base the TSC
+   value at that time, which timer_nanos() counts from.  tsc_base
+   is taken on a tick boundary, so tsc_base_ns, the tick-derived
+   time at that boundary, carries the clock on from where the
+   tick-based fallback left it. */
+#define TSC_CALIBRATE_TICKS 5
+#define NS_PER_TICK (1000 * 1000 * 1000 / TIMER_FREQ)
+static uint64_t tsc_hz;
+static uint64_t tsc_base;
+static int64_t tsc_base_ns;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void wheel_insert (struct timer_event *);
+static void wheel_advance (void);
+static int64_t wheel_next_expiry (int64_t max);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -37,7 +103,13 @@ timer_init (void)
 {
   /* 8254 input frequency divided by TIMER_FREQ, rounded to
      nearest. */
-  uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+  uint16_t count = PIT_TICK;
+  int level, slot;
+
+  seqlock_init (&ticks_seq);
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    for (slot = 0; slot < WHEEL_SLOTS; slot++)
+      list_init (&wheel[level][slot]);
 
   outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
   outb (0x40, count & 0xff);
@@ -51,6 +123,9 @@ void
 timer_calibrate (void) 
 {
   unsigned high_bit, test_bit;
+  int64_t base_ticks;
+  uint64_t base, hz;
+  enum intr_level old_level;
 
   ASSERT (intr_get_level () == INTR_ON);
   printf ("Calibrating timer...  ");
@@ -71,16 +146,82 @@ timer_calibrate (void)
       loops_per_tick |= test_bit;
 
   printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+  /* Count TSC cycles across a few whole timer ticks. */
+  printf ("Calibrating TSC...  ");
+  base_ticks = ticks;
+  while (ticks == base_ticks)
+    barrier ();
+  base_ticks = ticks;
+  base = timer_cycles ();
+  while (ticks - base_ticks < TSC_CALIBRATE_TICKS)
+    barrier ();
+  hz = (timer_cycles () - base) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+
+  /* Switch timer_nanos() over to the TSC in one step, so that an
+     interrupt handler never sees a half-written clock. */
+  old_level = intr_disable ();
+  tsc_base = base;
+  tsc_base_ns = base_ticks * NS_PER_TICK;
+  tsc_hz = hz;
+  intr_set_level (old_level);
+  printf ("%'"PRIu64" cycles/s.\n", tsc_hz);
+}
+
+/* Returns the CPU's time-stamp counter. */
+uint64_t
+timer_cycles (void)
+{
+  uint64_t tsc;
+
+  /* See [IA32-v2b] "RDTSC". */
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Returns the number of nanoseconds since the OS booted.  Until
+   the TSC is calibrated, this has only timer tick resolution. */
+int64_t
+timer_nanos (void)
+{
+  uint64_t cycles;
+
+  if (tsc_hz == 0)
+    return timer_ticks () * NS_PER_TICK;
+
+  cycles = timer_cycles () - tsc_base;
+  return tsc_base_ns + timer_cycles_to_nanos (cycles);
+}
+
+/* Converts CYCLES, a difference between two timer_cycles()
+   values, to nanoseconds. */
+int64_t
+timer_cycles_to_nanos (uint64_t cycles)
+{
+  if (tsc_hz == 0)
+    return 0;
+
+  /* Split the conversion so that CYCLES * 10**9 cannot
+     overflow. */
+  return (cycles / tsc_hz) * 1000000000ULL
+         + (cycles % tsc_hz) * 1000000000ULL / tsc_hz;
 }
 
 /* Returns the number of timer ticks since the OS booted. */
 int64_t
 timer_ticks (void) 
 {
-  enum intr_level old_level = intr_disable ();
-  int64_t t = ticks;
-  intr_set_level (old_level);
-  barrier ();
+  unsigned seq;
+  int64_t t;
+
+  /* A 64-bit load takes two instructions, so it may be torn by a
+     timer interrupt in between. */
+  do
+    {
+      seq = seqlock_read_begin (&ticks_seq);
+      t = ticks;
+    }
+  while (seqlock_read_retry (&ticks_seq, seq));
   return t;
 }
 
@@ -92,78 +233,37 @@ timer_elapsed (int64_t then)
   return timer_ticks () - then;
 }
 
-static bool comp_tick(const struct list_elem *A, const struct list_elem *B, void *aux)
+/* Wakes up the thread sleeping in timer_sleep(). */
+static void
+sleep_expired (struct timer_event *e UNUSED, void *t_)
 {
-    const struct thread *threadA = list_entry(A, struct thread, elem);
-    const struct thread *threadB = list_entry(B, struct thread, elem);
-    ASSERT(aux == NULL);
+  struct thread *t = t_;
 
-    if(threadA->ticks < threadB->ticks)
-    {
-        return true;
-    }
-    else if(threadA->ticks == threadB->ticks)
-    {
-        return threadA->priority < threadB->priority? true:false;
-    }
-    else
-    {
-        return false;
-    }
+  thread_unblock (t);
+  if (t->priority > thread_current ()->priority)
+    intr_yield_on_return ();
 }
+
 /* Suspends execution for approximately TICKS timer ticks. */
 void
 timer_sleep (int64_t ticks) 
 {
-  /* original code
-  int64_t start = timer_ticks ();
+  struct timer_event e;
+  enum intr_level old_level;
 
   ASSERT (intr_get_level () == INTR_ON);
-  while (timer_elapsed (start) < ticks) 
-    thread_yield ();
-  */
-
-  enum intr_level old_level;
-  struct thread *t = thread_current();
-
-  ASSERT(intr_get_level() == INTR_ON);
-
-  /* 
-   * to make INTR_OFF call intr_disable 
-   * set struct thread's tick and then block it
-   * after that insert it into list for remember which thread is blocked
-   * and recover intr level
-   * */
-  old_level = intr_disable();
-  t->ticks = ticks + timer_ticks();
-  list_insert_ordered(&blocked_list, &t->elem, comp_tick, NULL);
-  thread_block();
-
-  intr_set_level(old_level);
-}
-/* wake up blocked thread */
-static void
-thread_wake(void)
-{
-  const struct list_elem *elem;
-  struct thread *t;
-
-  while(!list_empty(&blocked_list))
-  {
-      elem = list_front(&blocked_list);
-      t = list_entry(elem, struct thread, elem);
-
-      if(ticks >= t->ticks)
-      {
-          list_pop_front(&blocked_list);
-          thread_unblock(t);
-      }
-      else
-      {
-          return;
-      }
-  }
+  if (ticks <= 0)
+    return;
+
+  /* The event lives on our stack, which is fine because we do
+     not return until it has fired. */
+  timer_event_init (&e, sleep_expired, thread_current ());
+  old_level = intr_disable ();
+  timer_event_add (&e, ticks);
+  thread_block ();
+  intr_set_level (old_level);
 }
+
 /* Suspends execution for approximately MS milliseconds. */
 void
 timer_msleep (int64_t ms) 
@@ -190,15 +290,274 @@ void
 timer_print_stats (void) 
 {
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+  if (timer_nohz)
+    printf ("Timer: %lld tickless idle periods, %lld ticks replayed\n",
+            nohz_idles, nohz_replayed);
+}
+
+/* Returns the count left in PIT counter 0. */
+static unsigned
+pit_read (void)
+{
+  uint8_t lo, hi;
+
+  outb (0x43, 0x00);    /* CW: latch counter 0. */
+  lo = inb (0x40);
+  hi = inb (0x40);
+  return (hi << 8) | lo;
+}
+
+/* Programs PIT counter 0 with COUNT in the given MODE. */
+static void
+pit_program (int mode, unsigned count)
+{
+  outb (0x43, 0x30 | (mode << 1));      /* CW: counter 0, LSB then MSB. */
+  outb (0x40, count & 0xff);
+  outb (0x40, count >> 8);
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  If tickless idle is enabled and no timer event is due
+   within the next tick, stops the periodic tick until the next
+   one is. */
+void
+timer_idle_enter (void)
+{
+  int64_t n;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_nohz || nohz_armed)
+    return;
+  n = wheel_next_expiry (NOHZ_MAX_TICKS);
+  if (n < 2)
+    return;
+
+  /* Count the part of the current tick that has already gone by,
+     then aim the one-shot at the boundary of the Nth tick. */
+  nohz_residue += PIT_TICK - pit_read ();
+  nohz_count = n * PIT_TICK - nohz_residue;
+  pit_program (0, nohz_count);
+  nohz_armed = true;
+  nohz_idles++;
+}
+
+/* Leaves tickless mode after ELAPSED PIT counts of the one-shot
+   period: restarts the periodic tick and replays the ticks that
+   were skipped. */
+static void
+nohz_disarm (unsigned elapsed)
+{
+  int64_t n;
+
+  pit_program (2, PIT_TICK);
+  nohz_armed = false;
+
+  elapsed += nohz_residue;
+  n = elapsed / PIT_TICK;
+  nohz_residue = elapsed % PIT_TICK;
+  nohz_replayed += n;
+
+  while (n-- > 0)
+    {
+      seqlock_write_begin (&ticks_seq);
+      ticks++;
+      seqlock_write_end (&ticks_seq);
+      thread_tick ();
+    }
+  wheel_advance ();
+}
+
+/* Called on entry to every external interrupt handler.  If the
+   CPU was woken from tickless idle by something other than the
+   one-shot timer, catches up on the ticks that went by. */
+void
+timer_nohz_exit (void)
+{
+  unsigned left;
+
+  if (!nohz_armed)
+    return;
+
+  /* After reaching zero the counter wraps and keeps counting
+     down, so a count above the one programmed means the timer
+     fired and timer_interrupt() will be along shortly. */
+  left = pit_read ();
+  if (left == 0 || left > nohz_count)
+    return;
+  nohz_disarm (nohz_count - left);
 }
 
 /* Timer interrupt handler. */
 static void
-timer_interrupt (struct intr_frame *args UNUSED)
+timer_interrupt (struct intr_frame *args)
 {
+  if (profile_enabled)
+    profile_sample (args);
+
+  if (nohz_armed)
+    {
+      /* End of a tickless idle period. */
+      nohz_disarm (nohz_count);
+      return;
+    }
+  seqlock_write_begin (&ticks_seq);
   ticks++;
+  seqlock_write_end (&ticks_seq);
   thread_tick ();
-  thread_wake();
+  wheel_advance ();
+}
+
+/* Initializes timer event E to call FUNC with AUX. */
+void
+timer_event_init (struct timer_event *e, timer_event_func *func, void *aux)
+{
+  ASSERT (e != NULL);
+  ASSERT (func != NULL);
+
+  e->pending = false;
+  e->period = 0;
+  e->func = func;
+  e->aux = aux;
+}
+
+/* Arms E to fire once, TICKS timer ticks from now (at least one).
+   E must not already be pending. */
+void
+timer_event_add (struct timer_event *e, int64_t ticks)
+{
+  enum intr_level old_level = intr_disable ();
+
+  ASSERT (!e->pending);
+  e->expires = wheel_time + (ticks > 0 ? ticks : 1);
+  e->period = 0;
+  wheel_insert (e);
+  intr_set_level (old_level);
+}
+
+/* Arms E to fire every PERIOD timer ticks, starting PERIOD ticks
+   from now, until cancelled.  E must not already be pending. */
+void
+timer_event_add_periodic (struct timer_event *e, int64_t period)
+{
+  enum intr_level old_level = intr_disable ();
+
+  ASSERT (!e->pending);
+  ASSERT (period > 0);
+  e->expires = wheel_time + period;
+  e->period = period;
+  wheel_insert (e);
+  intr_set_level (old_level);
+}
+
+/* Disarms E.  Returns true if E was pending, false if it had
+   already fired (or was never armed). */
+bool
+timer_event_cancel (struct timer_event *e)
+{
+  enum intr_level old_level = intr_disable ();
+  bool pending = e->pending;
+
+  if (pending)
+    {
+      list_remove (&e->elem);
+      e->pending = false;
+    }
+  intr_set_level (old_level);
+  return pending;
+}
+
+/* Puts E in the wheel slot that covers its deadline. */
+static void
+wheel_insert (struct timer_event *e)
+{
+  int64_t delta = e->expires - wheel_time;
+  int64_t when = e->expires;
+  int level;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (delta < 0)
+    when = wheel_time;
+  else if (delta >= (int64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS))
+    when = wheel_time + ((int64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+
+  for (level = 0; level < WHEEL_LEVELS - 1; level++)
+    if (when - wheel_time < (int64_t) 1 << (WHEEL_BITS * (level + 1)))
+      break;
+
+  list_push_back (&wheel[level][(when >> (WHEEL_BITS * level)) & WHEEL_MASK],
+                  &e->elem);
+  e->pending = true;
+}
+
+/* Moves every event in slot SLOT of LEVEL to the slot that now
+   covers its deadline. */
+static void
+wheel_cascade (int level, int slot)
+{
+  struct list *l = &wheel[level][slot];
+
+  while (!list_empty (l))
+    wheel_insert (list_entry (list_pop_front (l), struct timer_event, elem));
+}
+
+/* Returns how many ticks from now the wheel next needs to run,
+   or MAX if that is further away.  A level 0 wrap counts, since
+   it may cascade events down from higher levels. */
+static int64_t
+wheel_next_expiry (int64_t max)
+{
+  int64_t i;
+
+  for (i = 1; i < max; i++)
+    {
+      int slot = (wheel_time + i) & WHEEL_MASK;
+      if (slot == 0 || !list_empty (&wheel[0][slot]))
+        return i;
+    }
+  return max;
+}
+
+/* Advances the wheel to `ticks', firing every event that has
+   become due. */
+static void
+wheel_advance (void)
+{
+  while (wheel_time < ticks)
+    {
+      struct list *due;
+      int level;
+
+      wheel_time++;
+      for (level = 1; level < WHEEL_LEVELS; level++)
+        {
+          int64_t idx = wheel_time >> (WHEEL_BITS * (level - 1));
+          if ((idx & WHEEL_MASK) != 0)
+            break;
+          wheel_cascade (level, (idx >> WHEEL_BITS) & WHEEL_MASK);
+        }
+
+      due = &wheel[0][wheel_time & WHEEL_MASK];
+      while (!list_empty (due))
+        {
+          struct timer_event *e = list_entry (list_pop_front (due),
+                                              struct timer_event, elem);
+          e->pending = false;
+          if (e->expires > wheel_time)
+            {
+              /* Parked in the top level; not due yet. */
+              wheel_insert (e);
+              continue;
+            }
+          if (e->period > 0)
+            {
+              e->expires += e->period;
+              wheel_insert (e);
+            }
+          e->func (e, e->aux);
+        }
+    }
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
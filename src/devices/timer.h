@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -13,6 +15,11 @@ void timer_calibrate (void);
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
 
+/* High-resolution clock. */
+uint64_t timer_cycles (void);
+int64_t timer_nanos (void);
+int64_t timer_cycles_to_nanos (uint64_t cycles);
+
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
@@ -20,4 +27,33 @@ void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+/* Tickless idle. */
+extern bool timer_nohz;
+void timer_idle_enter (void);
+void timer_nohz_exit (void);
+
+/* Kernel timer event.
+
+   FUNC is called with AUX from the timer interrupt handler, with
+   interrupts off, once the event expires.  It must not sleep.  A
+   periodic event is rearmed before FUNC is called, so FUNC may
+   cancel it. */
+struct timer_event;
+typedef void timer_event_func (struct timer_event *, void *aux);
+
+struct timer_event
+  {
+    struct list_elem elem;      /* Timer wheel slot element. */
+    int64_t expires;            /* Tick at which to fire. */
+    int64_t period;             /* Ticks between firings, 0 if one-shot. */
+    bool pending;               /* Is the event on the wheel? */
+    timer_event_func *func;     /* Callback. */
+    void *aux;                  /* Callback argument. */
+  };
+
+void timer_event_init (struct timer_event *, timer_event_func *, void *aux);
+void timer_event_add (struct timer_event *, int64_t ticks);
+void timer_event_add_periodic (struct timer_event *, int64_t period);
+bool timer_event_cancel (struct timer_event *);
+
 #endif /* devices/timer.h */
@@ -37,19 +37,15 @@ main (int argc, char *argv[])
       return EXIT_FAILURE;
     }
 
-  /* Copy data. */
-  for (;;) 
-    {
-      char buffer[1024];
-      int bytes_read = read (in_fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
-        break;
-      if (write (out_fd, buffer, bytes_read) != bytes_read) 
-        {
-          printf ("%s: write failed\n", argv[2]);
-          return EXIT_FAILURE;
-        }
-    }
+  /* Copy data inside the kernel.  A call that copies nothing
+     before the end of the input means the output could not take
+     any more. */
+  while (tell (in_fd) < (unsigned) filesize (in_fd))
+    if (copy_file_range (in_fd, out_fd, 65536) <= 0)
+      {
+        printf ("%s: copy failed\n", argv[2]);
+        return EXIT_FAILURE;
+      }
 
   return EXIT_SUCCESS;
 }
@@ -5,6 +5,10 @@
 
 static void read_line (char line[], size_t);
 static bool backspace (char **pos, char line[]);
+static void run_pipeline (char *line);
+
+/* Most commands in one pipeline. */
+#define MAX_STAGES 8
 
 int
 main (void)
@@ -30,6 +34,8 @@ main (void)
         {
           /* Empty command. */
         }
+      else if (strchr (command, '|') != NULL)
+        run_pipeline (command);
       else
         {
           pid_t pid = exec (command);
@@ -44,6 +50,90 @@ main (void)
   return EXIT_SUCCESS;
 }
 
+/* Returns S with leading and trailing spaces removed, modifying
+   S in place. */
+static char *
+trim (char *s)
+{
+  char *end;
+
+  while (*s == ' ')
+    s++;
+  end = s + strlen (s);
+  while (end > s && end[-1] == ' ')
+    *--end = '\0';
+  return s;
+}
+
+/* Runs the commands in LINE, separated by `|', so that each
+   one's standard output feeds the next one's standard input, and
+   reports their exit codes once all have finished.
+
+   Each command inherits the shell's descriptors when it starts,
+   so the shell points its own standard input and output at the
+   pipes with dup2() just for the exec(), then closes them again,
+   which puts the console back. */
+static void
+run_pipeline (char *line) 
+{
+  char *stages[MAX_STAGES];
+  pid_t pids[MAX_STAGES];
+  char *stage, *save_ptr;
+  int stage_cnt = 0;
+  int in_fd = -1;
+  int i;
+
+  for (stage = strtok_r (line, "|", &save_ptr); stage != NULL;
+       stage = strtok_r (NULL, "|", &save_ptr))
+    {
+      if (stage_cnt == MAX_STAGES)
+        {
+          printf ("pipeline too long\n");
+          return;
+        }
+      stages[stage_cnt++] = trim (stage);
+    }
+
+  for (i = 0; i < stage_cnt; i++)
+    {
+      bool last = i == stage_cnt - 1;
+      int fds[2];
+
+      if (!last && !pipe (fds))
+        {
+          printf ("pipe failed\n");
+          break;
+        }
+      if (in_fd >= 0)
+        dup2 (in_fd, STDIN_FILENO);
+      if (!last)
+        dup2 (fds[1], STDOUT_FILENO);
+
+      pids[i] = exec (stages[i]);
+
+      /* Back to the console. */
+      close (STDIN_FILENO);
+      close (STDOUT_FILENO);
+      if (in_fd >= 0)
+        close (in_fd);
+      in_fd = -1;
+      if (!last)
+        {
+          close (fds[1]);
+          in_fd = fds[0];
+        }
+    }
+  if (in_fd >= 0)
+    close (in_fd);
+
+  stage_cnt = i;
+  for (i = 0; i < stage_cnt; i++)
+    if (pids[i] != PID_ERROR)
+      printf ("\"%s\": exit code %d\n", stages[i], wait (pids[i]));
+    else
+      printf ("\"%s\": exec failed\n", stages[i]);
+}
+
 /* Reads a line of input from the user into LINE, which has room
    for SIZE bytes.  Handles backspace and Ctrl+U in the ways
    expected by Unix users.  On return, LINE will always be
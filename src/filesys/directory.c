@@ -336,3 +336,49 @@ dir_readdir (struct dir *dir, char name[NAME_MAX + 1])
     }
   return false;
 }
+
+/* Reads up to CNT entries, other than "." and "..", from DIR
+   into RECORDS, starting from DIR's current position, which it
+   advances past them.  Entries are read from disk a sector's
+   worth at a time.  Returns the number of records filled in,
+   which is less than CNT only at the end of the directory. */
+size_t
+dir_read_entries (struct dir *dir, struct dir_record *records, size_t cnt)
+{
+  struct dir_entry entries[DISK_SECTOR_SIZE / sizeof (struct dir_entry)];
+  size_t n = 0;
+
+  while (n < cnt)
+    {
+      off_t bytes = inode_read_at (dir->inode, entries, sizeof entries,
+                                   dir->pos);
+      size_t entry_cnt = bytes / sizeof *entries;
+      size_t i;
+
+      if (entry_cnt == 0)
+        break;
+      for (i = 0; i < entry_cnt && n < cnt; i++)
+        {
+          struct dir_entry *e = &entries[i];
+          struct dir_record *r;
+
+          dir->pos += sizeof *e;
+          if (!e->in_use || !strcmp (e->name, ".") || !strcmp (e->name, ".."))
+            continue;
+
+          r = &records[n++];
+          r->inumber = e->inode_sector;
+          strlcpy (r->name, e->name, sizeof r->name);
+#ifdef EFILESYS
+          {
+            struct inode *inode = inode_open (e->inode_sector);
+            r->is_dir = inode != NULL && is_inode_dir (inode);
+            inode_close (inode);
+          }
+#else
+          r->is_dir = false;
+#endif
+        }
+    }
+  return n;
+}
@@ -13,6 +13,15 @@
 
 struct inode;
 
+/* A directory entry as reported by dir_read_entries().
+   Must match struct dirent in lib/user/syscall.h. */
+struct dir_record
+  {
+    disk_sector_t inumber;              /* Sector number of header. */
+    bool is_dir;                        /* Is it a directory? */
+    char name[NAME_MAX + 1];            /* Null terminated file name. */
+  };
+
 /* Opening and closing directories. */
 struct dir *dir_open (struct inode *);
 struct dir *dir_open_root (void);
@@ -25,6 +34,7 @@ bool dir_lookup (const struct dir *, const char *name, struct inode **);
 bool dir_add (struct dir *, const char *name, disk_sector_t);
 bool dir_remove (struct dir *, const char *name);
 bool dir_readdir (struct dir *, char name[NAME_MAX + 1]);
+size_t dir_read_entries (struct dir *, struct dir_record *, size_t cnt);
 
 #ifdef EFILESYS
 bool dir_create (disk_sector_t, size_t, disk_sector_t);
@@ -113,6 +113,45 @@ file_write_at (struct file *file, const void *buffer, off_t size,
   return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Reads SIZE bytes from FILE into BUFFER at the file's current
+   position, as file_read(), but moves whole sectors directly
+   from disk into BUFFER.  BUFFER must stay resident until this
+   returns.  See inode_read_direct(). */
+off_t
+file_read_direct (struct file *file, void *buffer, off_t size) 
+{
+  off_t bytes_read = inode_read_direct (file->inode, buffer, size, file->pos);
+  file->pos += bytes_read;
+  return bytes_read;
+}
+
+/* Writes SIZE bytes from BUFFER into FILE at the file's current
+   position, as file_write(), but moves whole sectors directly
+   from BUFFER to disk.  BUFFER must stay resident until this
+   returns.  See inode_write_direct(). */
+off_t
+file_write_direct (struct file *file, const void *buffer, off_t size) 
+{
+  off_t bytes_written = inode_write_direct (file->inode, buffer, size,
+                                            file->pos);
+  file->pos += bytes_written;
+  return bytes_written;
+}
+
+/* Copies up to SIZE bytes from SRC, starting at SRC's current
+   position, to DST at DST's current position, advancing both.
+   The data never leaves the kernel.  Returns the number of bytes
+   copied.  See inode_copy(). */
+off_t
+file_copy (struct file *dst, struct file *src, off_t size) 
+{
+  off_t bytes_copied = inode_copy (dst->inode, dst->pos,
+                                   src->inode, src->pos, size);
+  src->pos += bytes_copied;
+  dst->pos += bytes_copied;
+  return bytes_copied;
+}
+
 /* Prevents write operations on FILE's underlying inode
    until file_allow_write() is called or FILE is closed. */
 void
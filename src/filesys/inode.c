@@ -6,8 +6,11 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
@@ -69,6 +72,7 @@ struct disk_cache
 
 static void disk_read_with_cache(struct disk *, disk_sector_t, void *, off_t, size_t);
 static void disk_write_with_cache(struct disk *, disk_sector_t, void *, off_t, size_t);
+static void disk_cache_sync(struct disk *, disk_sector_t, size_t, bool);
 
 struct list disk_cache_list;
 #endif
@@ -81,6 +85,7 @@ struct inode
     int open_cnt;                       /* Number of openers. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+    unsigned write_cnt;                 /* Writes while open. */
     struct inode_disk data;             /* Inode content. */
     struct entry_block *iblock_ptr;
     struct entry_block_ptrs *diblock_ptr;
@@ -216,14 +221,22 @@ extend_inode(struct inode_disk *disk_inode, struct entry_block *iblocks, struct
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Caches for struct inode and struct disk_cache. */
+static struct slab_cache inode_cache;
+#ifdef CFILESYS
+static struct slab_cache disk_cache_cache;
+#endif
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  slab_cache_init (&inode_cache, "inode", sizeof (struct inode), 0);
 #ifdef CFILESYS
   list_init(&disk_cache_list);
   lock_init(&cache_lock);
+  slab_cache_init(&disk_cache_cache, "disk_cache", sizeof(struct disk_cache), 0);
 #endif
 }
 
@@ -383,7 +396,7 @@ inode_open (disk_sector_t sector)
     }
 
   /* Allocate memory. */
-  inode = malloc (sizeof *inode);
+  inode = slab_alloc (&inode_cache);
   if (inode == NULL)
     return NULL;
 
@@ -392,6 +405,7 @@ inode_open (disk_sector_t sector)
   inode->sector = sector;
   inode->open_cnt = 1;
   inode->deny_write_cnt = 0;
+  inode->write_cnt = 0;
   inode->removed = false;
 
 #ifdef EFILESYS
@@ -423,6 +437,22 @@ inode_get_inumber (const struct inode *inode)
   return inode->sector;
 }
 
+/* Returns the number of writes made to INODE since it was opened
+   by its first opener.  Any change to the file's contents
+   changes this number, as long as INODE stays open. */
+unsigned
+inode_get_write_cnt (const struct inode *inode)
+{
+  return inode->write_cnt;
+}
+
+/* Returns true if INODE has been removed. */
+bool
+inode_is_removed (const struct inode *inode)
+{
+  return inode->removed;
+}
+
 /* Closes INODE and writes it to disk.
    If this was the last reference to INODE, frees its memory.
    If INODE was also a removed inode, frees its blocks. */
@@ -466,7 +496,7 @@ inode_close (struct inode *inode)
           free(inode->diblock_ptr);
       }
 #endif
-      free (inode); 
+      slab_free (&inode_cache, inode);
     }
 }
 
@@ -556,6 +586,8 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 #endif
   if (inode->deny_write_cnt)
     return 0;
+  if (size > 0)
+    inode->write_cnt++;
 
   while (size > 0) 
     {
@@ -702,6 +734,136 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
   return bytes_written;
 }
 
+/* Moves the SIZE bytes of INODE at OFFSET directly between the
+   disk and BUFFER, one multi-sector transfer per run of
+   physically contiguous sectors.  OFFSET and SIZE must be
+   multiples of DISK_SECTOR_SIZE and lie within the inode.  Any
+   cached copies of the sectors are written back before a read
+   and dropped before a write, so buffered and direct I/O see the
+   same data. */
+static void
+inode_direct_io (struct inode *inode, uint8_t *buffer, off_t size,
+                 off_t offset, bool write)
+{
+  while (size > 0)
+    {
+      disk_sector_t first = byte_to_sector (inode, offset);
+      size_t cnt = 1;
+      off_t run;
+
+      while ((off_t) (cnt * DISK_SECTOR_SIZE) < size
+             && byte_to_sector (inode, offset + cnt * DISK_SECTOR_SIZE)
+                == first + cnt)
+        cnt++;
+      run = cnt * DISK_SECTOR_SIZE;
+
+#ifdef CFILESYS
+      disk_cache_sync (filesys_disk, first, cnt, write);
+#endif
+      if (write)
+        disk_write_multiple (filesys_disk, first, buffer, cnt);
+      else
+        disk_read_multiple (filesys_disk, first, buffer, cnt);
+
+      buffer += run;
+      offset += run;
+      size -= run;
+    }
+}
+
+/* Returns how many of the SIZE bytes at OFFSET in INODE can be
+   transferred by inode_direct_io(): 0 unless OFFSET and SIZE are
+   sector-aligned, otherwise the whole sectors before end of
+   file. */
+static off_t
+direct_bytes (struct inode *inode, off_t size, off_t offset)
+{
+  off_t inode_left = inode_length (inode) - offset;
+
+  if (offset % DISK_SECTOR_SIZE != 0 || size % DISK_SECTOR_SIZE != 0
+      || inode_left <= 0)
+    return 0;
+  inode_left -= inode_left % DISK_SECTOR_SIZE;
+  return size < inode_left ? size : inode_left;
+}
+
+/* Like inode_read_at(), but if OFFSET and SIZE are multiples of
+   DISK_SECTOR_SIZE, reads the whole sectors straight from disk
+   into BUFFER, bypassing the buffer cache.  BUFFER must stay
+   resident until this returns.  A partial sector at end of file,
+   or a misaligned request, goes through inode_read_at(). */
+off_t
+inode_read_direct (struct inode *inode, void *buffer, off_t size,
+                   off_t offset)
+{
+  off_t direct = direct_bytes (inode, size, offset);
+
+  inode_direct_io (inode, buffer, direct, offset, false);
+  return direct + inode_read_at (inode, (uint8_t *) buffer + direct,
+                                 size - direct, offset + direct);
+}
+
+/* Like inode_write_at(), but writes whole sectors within the
+   current length of INODE straight from BUFFER to disk, as
+   inode_read_direct() does for reads.  Writing past end of file
+   goes through inode_write_at(), which extends the inode. */
+off_t
+inode_write_direct (struct inode *inode, const void *buffer, off_t size,
+                    off_t offset)
+{
+  off_t direct;
+
+  if (inode->deny_write_cnt)
+    return 0;
+  if (size > 0)
+    inode->write_cnt++;
+  direct = direct_bytes (inode, size, offset);
+  inode_direct_io (inode, (uint8_t *) buffer, direct, offset, true);
+  return direct + inode_write_at (inode, (const uint8_t *) buffer + direct,
+                                  size - direct, offset + direct);
+}
+
+/* Copies up to SIZE bytes from SRC starting at SRC_OFS to DST
+   starting at DST_OFS, without passing the data through user
+   memory.  Sector-aligned stretches move with multi-sector disk
+   transfers wherever the sectors of each inode are contiguous,
+   the rest through the buffer cache, as in inode_read_direct()
+   and inode_write_direct().  Returns the number of bytes copied,
+   which is less than SIZE at end of SRC, if DST cannot grow or
+   if no bounce page is available. */
+off_t
+inode_copy (struct inode *dst, off_t dst_ofs, struct inode *src,
+            off_t src_ofs, off_t size)
+{
+  uint8_t *bounce;
+  off_t bytes_copied = 0;
+
+  bounce = palloc_get_page (0);
+  if (bounce == NULL)
+    return 0;
+
+  while (size > 0)
+    {
+      off_t chunk = size < PGSIZE ? size : PGSIZE;
+      off_t bytes_read, bytes_written;
+
+      bytes_read = inode_read_direct (src, bounce, chunk, src_ofs);
+      if (bytes_read <= 0)
+        break;
+      bytes_written = inode_write_direct (dst, bounce, bytes_read, dst_ofs);
+      bytes_copied += bytes_written;
+      if (bytes_written < bytes_read)
+        break;
+
+      size -= bytes_read;
+      src_ofs += bytes_read;
+      dst_ofs += bytes_read;
+    }
+
+  palloc_free_page (bounce);
+  return bytes_copied;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 void
@@ -749,8 +911,24 @@ disk_cache_WB_all()
     {
         disk = list_entry(list_pop_front(&disk_cache_list), struct disk_cache, elem);
         disk_cache_WB(disk);
-        free(disk);
+        slab_free(&disk_cache_cache, disk);
+    }
+}
+
+/* Writes every dirty cached sector back to disk, keeping the
+   cached copies. */
+void
+disk_cache_flush(void)
+{
+    struct list_elem *elem;
+    lock_acquire(&cache_lock);
+    for(elem = list_begin(&disk_cache_list); elem != list_end(&disk_cache_list); elem = list_next(elem))
+    {
+        struct disk_cache *cache = list_entry(elem, struct disk_cache, elem);
+        disk_cache_WB(cache);
+        cache->is_dirty = false;
     }
+    lock_release(&cache_lock);
 }
 
 static struct disk_cache *
@@ -771,12 +949,13 @@ lookup_disk_cache(struct disk * disk, disk_sector_t no)
     // EVICT
     if(list_size(&disk_cache_list) >= 64)
     {
-        disk_cache_WB(list_entry(list_pop_back(&disk_cache_list), struct disk_cache, elem));
-        free(cache);
+        cache = list_entry(list_pop_back(&disk_cache_list), struct disk_cache, elem);
+        disk_cache_WB(cache);
+        slab_free(&disk_cache_cache, cache);
     }
 
     // LOAD TO DISK
-    cache = malloc(sizeof(struct disk_cache));
+    cache = slab_alloc(&disk_cache_cache);
     if(cache != NULL)
     {
         cache->disk = disk;
@@ -788,6 +967,35 @@ lookup_disk_cache(struct disk * disk, disk_sector_t no)
     return cache;
 }
 
+/* Brings the cache in line with a direct transfer of the CNT
+   sectors starting at NO on DISK.  Dirty cached copies are
+   written back; if INVALIDATE, because the transfer is about to
+   overwrite the disk copies, cached copies are dropped instead. */
+static void
+disk_cache_sync(struct disk *disk, disk_sector_t no, size_t cnt, bool invalidate)
+{
+    struct list_elem *elem, *next;
+    lock_acquire(&cache_lock);
+    for(elem = list_begin(&disk_cache_list); elem != list_end(&disk_cache_list); elem = next)
+    {
+        struct disk_cache *cache = list_entry(elem, struct disk_cache, elem);
+        next = list_next(elem);
+        if(cache->disk != disk || cache->no < no || cache->no - no >= cnt)
+            continue;
+        if(invalidate)
+        {
+            list_remove(elem);
+            slab_free(&disk_cache_cache, cache);
+        }
+        else
+        {
+            disk_cache_WB(cache);
+            cache->is_dirty = false;
+        }
+    }
+    lock_release(&cache_lock);
+}
+
 static void
 disk_read_with_cache(struct disk *disk, disk_sector_t no, void *buffer, off_t start, size_t size)
 {
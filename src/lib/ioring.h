@@ -0,0 +1,68 @@
+#ifndef __LIB_IORING_H
+#define __LIB_IORING_H
+
+#include <stdint.h>
+
+/* Asynchronous I/O ring shared between a process and the kernel.
+
+   io_setup() maps IORING_PAGES + BUF_PAGES pages at a page-aligned
+   user address.  The first page holds a struct io_ring_hdr
+   followed by the submission and completion queues; the
+   remaining BUF_PAGES pages are the ring's buffer area.  Reads
+   and writes submitted on the ring transfer data between a file
+   and the buffer area only, which lets the kernel's I/O workers
+   reach it from outside the process.
+
+   Both queues are single-producer, single-consumer rings indexed
+   by free-running 32-bit counters; entry I lives in slot
+   I % entries.  The process produces submissions (advances
+   sq_tail) and consumes completions (advances cq_head); the
+   kernel does the reverse.  A process fills in an entry before
+   advancing the tail that publishes it, and io_enter() tells the
+   kernel to look. */
+
+#define IORING_PAGES 1          /* Pages for header and queues. */
+#define IORING_BUF_PAGES_MAX 32 /* Most buffer pages per ring. */
+#define IORING_SQ_ENTRIES 64    /* Submission queue slots. */
+#define IORING_CQ_ENTRIES 128   /* Completion queue slots. */
+
+/* Operations. */
+enum io_op
+  {
+    IO_OP_NOP,                  /* Complete immediately with 0. */
+    IO_OP_READ,                 /* Read from file into buffer area. */
+    IO_OP_WRITE,                /* Write from buffer area to file. */
+    IO_OP_FSYNC                 /* Flush cached file data to disk. */
+  };
+
+/* Submission queue entry. */
+struct io_sqe
+  {
+    uint32_t opcode;            /* An enum io_op. */
+    int32_t fd;                 /* File descriptor. */
+    uint32_t buf;               /* Offset into the buffer area. */
+    uint32_t len;               /* Bytes to transfer. */
+    int32_t offset;             /* File offset. */
+    uint32_t user_data;         /* Copied to the completion. */
+  };
+
+/* Completion queue entry. */
+struct io_cqe
+  {
+    uint32_t user_data;         /* From the submission. */
+    int32_t res;                /* Bytes transferred, or -1. */
+  };
+
+/* Ring header, at the start of the ring's first page. */
+struct io_ring_hdr
+  {
+    uint32_t sq_head;           /* Advanced by the kernel. */
+    uint32_t sq_tail;           /* Advanced by the process. */
+    uint32_t cq_head;           /* Advanced by the process. */
+    uint32_t cq_tail;           /* Advanced by the kernel. */
+    uint32_t buf_size;          /* Bytes in the buffer area. */
+    struct io_sqe sq[IORING_SQ_ENTRIES];
+    struct io_cqe cq[IORING_CQ_ENTRIES];
+  };
+
+#endif /* lib/ioring.h */
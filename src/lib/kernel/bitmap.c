@@ -28,6 +28,7 @@ struct bitmap
   {
     size_t bit_cnt;     /* Number of bits. */
     elem_type *bits;    /* Elements that represent bits. */
+    size_t hint;        /* Where bitmap_scan_and_flip_next() resumes. */
   };
 
 /* Returns the index of the element that contains the bit
@@ -60,6 +61,45 @@ byte_cnt (size_t bit_cnt)
   return sizeof (elem_type) * elem_cnt (bit_cnt);
 }
 
+/* Returns an elem_type with the CNT bits starting at bit OFS
+   turned on.  OFS + CNT must not exceed ELEM_BITS. */
+static inline elem_type
+range_mask (size_t ofs, size_t cnt)
+{
+  elem_type mask = cnt < ELEM_BITS ? ((elem_type) 1 << cnt) - 1 : (elem_type) -1;
+  return mask << ofs;
+}
+
+/* Returns element IDX of B, inverted if VALUE is false, so that
+   the bits set in the result are those equal to VALUE. */
+static inline elem_type
+elem_match (const struct bitmap *b, size_t idx, bool value)
+{
+  return value ? b->bits[idx] : ~b->bits[idx];
+}
+
+/* Returns the index of the least significant 1-bit in W, which
+   must be nonzero. */
+static inline size_t
+lowest_bit (elem_type w)
+{
+  elem_type bit;
+
+  asm ("bsfl %1, %0" : "=r" (bit) : "rm" (w) : "cc");
+  return bit;
+}
+
+/* Returns the number of 1-bits in W. */
+static inline size_t
+count_bits (elem_type w)
+{
+  size_t cnt = 0;
+
+  for (; w != 0; w &= w - 1)
+    cnt++;
+  return cnt;
+}
+
 /* Returns a bit mask in which the bits actually used in the last
    element of B's bits are set to 1 and the rest are set to 0. */
 static inline elem_type
@@ -83,6 +123,7 @@ bitmap_create (size_t bit_cnt)
     {
       b->bit_cnt = bit_cnt;
       b->bits = malloc (byte_cnt (bit_cnt));
+      b->hint = 0;
       if (b->bits != NULL || bit_cnt == 0)
         {
           bitmap_set_all (b, false);
@@ -105,6 +146,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 
   b->bit_cnt = bit_cnt;
   b->bits = (elem_type *) (b + 1);
+  b->hint = 0;
   bitmap_set_all (b, false);
   return b;
 }
@@ -214,18 +256,61 @@ bitmap_set_all (struct bitmap *b, bool value)
   bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element is updated atomically, but not the group as a
+   whole. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
-  
+  size_t end = start + cnt;
+
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  while (start < end)
+    {
+      size_t idx = elem_idx (start);
+      size_t ofs = start % ELEM_BITS;
+      size_t n = ELEM_BITS - ofs;
+      elem_type mask;
+
+      if (n > end - start)
+        n = end - start;
+      mask = range_mask (ofs, n);
+
+      /* See bitmap_mark() and bitmap_reset(). */
+      if (value)
+        asm ("orl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+      else
+        asm ("andl %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+      start += n;
+    }
+}
+
+/* Returns the index of the first bit in B at or after START and
+   before END that is set to VALUE, or END if there is none.
+   Whole elements that contain no such bit are skipped with a
+   single comparison each. */
+static size_t
+find_bit (const struct bitmap *b, size_t start, size_t end, bool value)
+{
+  size_t idx, last;
+  elem_type w;
+
+  if (start >= end)
+    return end;
+  idx = elem_idx (start);
+  last = elem_idx (end - 1);
+  w = elem_match (b, idx, value) & ((elem_type) -1 << (start % ELEM_BITS));
+  while (w == 0)
+    {
+      if (++idx > last)
+        return end;
+      w = elem_match (b, idx, value);
+    }
+  start = idx * ELEM_BITS + lowest_bit (w);
+  return start < end ? start : end;
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -240,9 +325,16 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (start + cnt <= b->bit_cnt);
 
   value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      value_cnt++;
+  for (i = start; i < start + cnt; )
+    {
+      size_t ofs = i % ELEM_BITS;
+      size_t n = ELEM_BITS - ofs;
+      if (n > start + cnt - i)
+        n = start + cnt - i;
+      value_cnt += count_bits (elem_match (b, elem_idx (i), value)
+                               & range_mask (ofs, n));
+      i += n;
+    }
   return value_cnt;
 }
 
@@ -251,16 +343,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) 
 {
-  size_t i;
-  
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
-  return false;
+  return find_bit (b, start, start + cnt, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -289,6 +376,37 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt)
 
 /* Finding set or unset bits. */
 
+/* Finds and returns the starting index of the first group of CNT
+   consecutive bits in B at or after START and ending at or
+   before END that are all set to VALUE, or BITMAP_ERROR if there
+   is none.
+
+   Alternates between finding the next bit set to VALUE, which
+   starts a candidate run, and the next bit set to !VALUE within
+   CNT bits of it, which ends the run too early.  The search
+   resumes after the bit that ended the run, so no bit is
+   examined more than twice. */
+static size_t
+scan_range (const struct bitmap *b, size_t start, size_t end, size_t cnt,
+            bool value)
+{
+  if (cnt == 0)
+    return start <= end ? start : BITMAP_ERROR;
+  while (start <= end && end - start >= cnt)
+    {
+      size_t run_start = find_bit (b, start, end, value);
+      size_t run_end;
+
+      if (end - run_start < cnt)
+        break;
+      run_end = find_bit (b, run_start, run_start + cnt, !value);
+      if (run_end == run_start + cnt)
+        return run_start;
+      start = run_end + 1;
+    }
+  return BITMAP_ERROR;
+}
+
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
@@ -299,15 +417,7 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
-  if (cnt <= b->bit_cnt) 
-    {
-      size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i; 
-    }
-  return BITMAP_ERROR;
+  return scan_range (b, start, b->bit_cnt, cnt, value);
 }
 
 /* Finds the first group of CNT consecutive bits in B at or after
@@ -326,6 +436,35 @@ bitmap_scan_and_flip (struct bitmap *b, size_t start, size_t cnt, bool value)
   return idx;
 }
 
+/* Like bitmap_scan_and_flip(), but begins searching where the
+   previous call left off instead of at a caller-supplied START,
+   wrapping around to the beginning of B if necessary.  This
+   "next fit" policy keeps allocators that hand out and release
+   slots in roughly FIFO order from rescanning the same allocated
+   prefix on every call. */
+size_t
+bitmap_scan_and_flip_next (struct bitmap *b, size_t cnt, bool value)
+{
+  size_t hint, idx;
+
+  ASSERT (b != NULL);
+
+  hint = b->hint <= b->bit_cnt ? b->hint : 0;
+  idx = scan_range (b, hint, b->bit_cnt, cnt, value);
+  if (idx == BITMAP_ERROR && hint > 0)
+    {
+      /* Wrap around, including groups that straddle HINT. */
+      size_t end = hint + cnt - 1;
+      idx = scan_range (b, 0, end < b->bit_cnt ? end : b->bit_cnt, cnt, value);
+    }
+  if (idx != BITMAP_ERROR)
+    {
+      bitmap_set_multiple (b, idx, cnt, !value);
+      b->hint = idx + cnt;
+    }
+  return idx;
+}
+
 /* File input and output. */
 
 #ifdef FILESYS
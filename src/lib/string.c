@@ -1,5 +1,29 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* The block and string functions below move data 32 bits at a
+   time with x86 string instructions (rep movsl, rep stosl) or
+   plain word loads, after handling any misaligned head or tail a
+   byte at a time.  They rely on the direction flag being clear,
+   which the System V ABI guarantees on function entry and
+   intr_entry establishes for interrupt handlers.
+
+   SSE versions would be faster still for large user-space
+   copies, but neither the kernel nor user programs are built
+   with SSE enabled (-msoft-float) and the kernel does not save
+   SSE state across context switches. */
+
+/* A word that may alias any other type, for word-at-a-time
+   loads from byte buffers. */
+typedef uint32_t __attribute__ ((may_alias)) word_t;
+
+/* Blocks shorter than this are handled a byte at a time: setting
+   up the word loop costs more than it saves. */
+#define WORD_MIN 16
+
+/* Returns nonzero if some byte of W is zero. */
+#define HAS_ZERO_BYTE(W) (((W) - 0x01010101u) & ~(W) & 0x80808080u)
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -12,8 +36,23 @@ memcpy (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  while (size-- > 0)
-    *dst++ = *src++;
+  if (size >= WORD_MIN)
+    {
+      /* Copy bytes until DST is aligned, then whole words. */
+      size_t head = -(uintptr_t) dst & 3;
+      size_t words = (size - head) / 4;
+
+      size = (size - head) % 4;
+      asm volatile ("rep movsb\n\t"
+                    "movl %3, %%ecx\n\t"
+                    "rep movsl"
+                    : "+D" (dst), "+S" (src), "+c" (head)
+                    : "r" (words)
+                    : "memory");
+    }
+  asm volatile ("rep movsb"
+                : "+D" (dst), "+S" (src), "+c" (size)
+                : : "memory");
 
   return dst_;
 }
@@ -29,20 +68,30 @@ memmove (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  if (dst < src) 
-    {
-      while (size-- > 0)
-        *dst++ = *src++;
-    }
-  else 
-    {
-      dst += size;
-      src += size;
-      while (size-- > 0)
-        *--dst = *--src;
-    }
+  if (dst <= src || dst >= src + size)
+    return memcpy (dst, src, size);
+
+  /* DST overlaps the end of SRC, so copy backward: first the
+     last SIZE % 4 bytes, then the rest a word at a time. */
+  {
+    size_t tail = size % 4;
+    size_t words = size / 4;
+
+    dst += size - 1;
+    src += size - 1;
+    asm volatile ("std\n\t"
+                  "rep movsb\n\t"
+                  "movl %3, %%ecx\n\t"
+                  "subl $3, %%esi\n\t"
+                  "subl $3, %%edi\n\t"
+                  "rep movsl\n\t"
+                  "cld"
+                  : "+D" (dst), "+S" (src), "+c" (tail)
+                  : "r" (words)
+                  : "memory", "cc");
+  }
 
-  return dst;
+  return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -58,6 +107,11 @@ memcmp (const void *a_, const void *b_, size_t size)
   ASSERT (a != NULL || size == 0);
   ASSERT (b != NULL || size == 0);
 
+  /* Skip over equal words; the byte loop finds which byte of an
+     unequal word differs. */
+  for (; size >= 4; a += 4, b += 4, size -= 4)
+    if (*(const word_t *) a != *(const word_t *) b)
+      break;
   for (; size-- > 0; a++, b++)
     if (*a != *b)
       return *a > *b ? +1 : -1;
@@ -281,9 +335,26 @@ memset (void *dst_, int value, size_t size)
   unsigned char *dst = dst_;
 
   ASSERT (dst != NULL || size == 0);
-  
-  while (size-- > 0)
-    *dst++ = value;
+
+  if (size >= WORD_MIN)
+    {
+      /* Store bytes until DST is aligned, then whole words. */
+      size_t head = -(uintptr_t) dst & 3;
+      size_t words = (size - head) / 4;
+      uint32_t pattern = (unsigned char) value * 0x01010101u;
+
+      size = (size - head) % 4;
+      asm volatile ("rep stosb\n\t"
+                    "movl %3, %%ecx\n\t"
+                    "rep stosl"
+                    : "+D" (dst), "+c" (head)
+                    : "a" (pattern), "r" (words)
+                    : "memory");
+    }
+  asm volatile ("rep stosb"
+                : "+D" (dst), "+c" (size)
+                : "a" (value)
+                : "memory");
 
   return dst_;
 }
@@ -296,8 +367,16 @@ strlen (const char *string)
 
   ASSERT (string != NULL);
 
-  for (p = string; *p != '\0'; p++)
-    continue;
+  /* Check bytes up to a word boundary, then whole words.  An
+     aligned word never straddles a page boundary, so reading
+     past the terminator cannot fault. */
+  for (p = string; (uintptr_t) p & 3; p++)
+    if (*p == '\0')
+      return p - string;
+  while (!HAS_ZERO_BYTE (*(const word_t *) p))
+    p += 4;
+  while (*p != '\0')
+    p++;
   return p - string;
 }
 
@@ -28,7 +28,30 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_NANOTIME,               /* Nanoseconds since boot. */
+    SYS_OPEN_FLAGS,             /* Open a file with flags. */
+    SYS_PREAD,                  /* Read from a file at an offset. */
+    SYS_PWRITE,                 /* Write to a file at an offset. */
+    SYS_READV,                  /* Read into several buffers. */
+    SYS_WRITEV,                 /* Write from several buffers. */
+    SYS_COPY_FILE_RANGE,        /* Copy between files in the kernel. */
+    SYS_GETDENTS,               /* Reads many directory entries. */
+    SYS_IO_SETUP,               /* Map an asynchronous I/O ring. */
+    SYS_IO_ENTER,               /* Submit to and wait on the ring. */
+    SYS_PIPE,                   /* Create a pipe. */
+    SYS_DUP2,                   /* Duplicate a file descriptor. */
+    SYS_SPLICE,                 /* Move data between a pipe and a file. */
+    SYS_SHM_CREATE,             /* Create a shared memory segment. */
+    SYS_SHM_ATTACH,             /* Map a shared memory segment. */
+    SYS_SHM_DETACH,             /* Unmap a shared memory segment. */
+    SYS_FORK                    /* Clone the current process. */
   };
 
+/* Flags for SYS_OPEN_FLAGS. */
+#define O_DIRECT 0x1            /* Move whole sectors directly between
+                                   user memory and disk. */
+
 #endif /* lib/syscall-nr.h */
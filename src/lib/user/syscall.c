@@ -61,6 +61,38 @@
           retval;                                               \
         })
 
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   and ARG3, and returns the return value as an `int'. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; "    \
+             "pushl %[arg0]; pushl %[number]; int $0x30; "      \
+             "addl $20, %%esp"                                  \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "g" (ARG0),                             \
+                 [arg1] "g" (ARG1),                             \
+                 [arg2] "g" (ARG2),                             \
+                 [arg3] "g" (ARG3)                              \
+               : "memory");                                     \
+          retval;                                               \
+        })
+
+/* Invokes syscall NUMBER, passing no arguments, and returns the
+   64-bit return value from EDX:EAX. */
+#define syscall0_64(NUMBER)                                     \
+        ({                                                      \
+          int64_t retval;                                       \
+          asm volatile                                          \
+            ("pushl %[number]; int $0x30; addl $4, %%esp"       \
+               : "=A" (retval)                                  \
+               : [number] "i" (NUMBER)                          \
+               : "memory");                                     \
+          retval;                                               \
+        })
+
 void
 halt (void) 
 {
@@ -182,3 +214,105 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+int64_t
+nanotime (void)
+{
+  return syscall0_64 (SYS_NANOTIME);
+}
+
+int
+open_flags (const char *file, int flags)
+{
+  return syscall2 (SYS_OPEN_FLAGS, file, flags);
+}
+
+int
+pread (int fd, void *buffer, unsigned length, int offset)
+{
+  return syscall4 (SYS_PREAD, fd, buffer, length, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned length, int offset)
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, length, offset);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+copy_file_range (int fd_in, int fd_out, int length)
+{
+  return syscall3 (SYS_COPY_FILE_RANGE, fd_in, fd_out, length);
+}
+
+int
+getdents (int fd, struct dirent *entries, int count)
+{
+  return syscall3 (SYS_GETDENTS, fd, entries, count);
+}
+
+bool
+io_setup (void *addr, unsigned buf_pages)
+{
+  return syscall2 (SYS_IO_SETUP, addr, buf_pages);
+}
+
+int
+io_enter (unsigned to_submit, unsigned min_complete)
+{
+  return syscall2 (SYS_IO_ENTER, to_submit, min_complete);
+}
+
+bool
+pipe (int fds[2])
+{
+  return syscall1 (SYS_PIPE, fds);
+}
+
+int
+dup2 (int oldfd, int newfd)
+{
+  return syscall2 (SYS_DUP2, oldfd, newfd);
+}
+
+int
+splice (int fd_in, int fd_out, int length)
+{
+  return syscall3 (SYS_SPLICE, fd_in, fd_out, length);
+}
+
+bool
+shm_create (const char *name, unsigned size)
+{
+  return syscall2 (SYS_SHM_CREATE, name, size);
+}
+
+bool
+shm_attach (const char *name, void *addr)
+{
+  return syscall2 (SYS_SHM_ATTACH, name, addr);
+}
+
+bool
+shm_detach (void *addr)
+{
+  return syscall1 (SYS_SHM_DETACH, addr);
+}
+
+pid_t
+fork (void)
+{
+  return syscall0 (SYS_FORK);
+}
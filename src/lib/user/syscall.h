@@ -2,7 +2,9 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <debug.h>
+#include <syscall-nr.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -15,6 +17,21 @@ typedef int mapid_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* One buffer of a readv() or writev(). */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    unsigned iov_len;           /* Length of buffer in bytes. */
+  };
+
+/* A directory entry filled in by getdents(). */
+struct dirent
+  {
+    int inumber;                        /* Inode number. */
+    bool isdir;                         /* Is it a directory? */
+    char name[READDIR_MAX_LEN + 1];     /* Null terminated name. */
+  };
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
@@ -45,4 +62,23 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+int64_t nanotime (void);
+int open_flags (const char *file, int flags);
+int pread (int fd, void *buffer, unsigned length, int offset);
+int pwrite (int fd, const void *buffer, unsigned length, int offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int copy_file_range (int fd_in, int fd_out, int length);
+int getdents (int fd, struct dirent *entries, int count);
+bool io_setup (void *addr, unsigned buf_pages);
+int io_enter (unsigned to_submit, unsigned min_complete);
+bool pipe (int fds[2]);
+int dup2 (int oldfd, int newfd);
+int splice (int fd_in, int fd_out, int length);
+bool shm_create (const char *name, unsigned size);
+bool shm_attach (const char *name, void *addr);
+bool shm_detach (void *addr);
+pid_t fork (void);
+
 #endif /* lib/user/syscall.h */
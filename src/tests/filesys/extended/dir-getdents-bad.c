@@ -0,0 +1,24 @@
+/* Calls getdents() on a regular file, on a descriptor that is
+   not open and with a negative count.  Each must return -1. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  struct dirent entry;
+  int dir, file;
+
+  CHECK (mkdir ("a"), "mkdir \"a\"");
+  CHECK (create ("f", 0), "create \"f\"");
+  CHECK ((dir = open ("a")) > 1, "open \"a\"");
+  CHECK ((file = open ("f")) > 1, "open \"f\"");
+  CHECK (getdents (file, &entry, 1) == -1,
+         "getdents on a file (must return -1)");
+  CHECK (getdents (12345, &entry, 1) == -1,
+         "getdents on a bad descriptor (must return -1)");
+  CHECK (getdents (dir, &entry, -1) == -1,
+         "getdents -1 entries (must return -1)");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(dir-getdents-bad) begin
+(dir-getdents-bad) mkdir "a"
+(dir-getdents-bad) create "f"
+(dir-getdents-bad) open "a"
+(dir-getdents-bad) open "f"
+(dir-getdents-bad) getdents on a file (must return -1)
+(dir-getdents-bad) getdents on a bad descriptor (must return -1)
+(dir-getdents-bad) getdents -1 entries (must return -1)
+(dir-getdents-bad) end
+EOF
+pass;
@@ -0,0 +1,58 @@
+/* Creates a directory with more entries than getdents() copies
+   out at once and reads them back a few at a time.  Every entry
+   must be returned exactly once. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define FILE_CNT 20
+
+void
+test_main (void)
+{
+  struct dirent entries[7];
+  bool seen[FILE_CNT + 1];
+  int fd, n, total, i;
+  char name[16];
+
+  CHECK (mkdir ("a"), "mkdir \"a\"");
+  msg ("creating a/f0 through a/f%d...", FILE_CNT - 1);
+  quiet = true;
+  for (i = 0; i < FILE_CNT; i++)
+    {
+      snprintf (name, sizeof name, "a/f%d", i);
+      CHECK (create (name, 0), "create \"%s\"", name);
+    }
+  quiet = false;
+  CHECK (mkdir ("a/d"), "mkdir \"a/d\"");
+  CHECK ((fd = open ("a")) > 1, "open \"a\"");
+  CHECK (getdents (fd, entries, 0) == 0, "getdents 0 entries");
+
+  memset (seen, 0, sizeof seen);
+  total = 0;
+  while ((n = getdents (fd, entries, 7)) > 0)
+    for (i = 0; i < n; i++)
+      {
+        struct dirent *e = &entries[i];
+        int idx;
+
+        if (!strcmp (e->name, "d"))
+          idx = FILE_CNT;
+        else if (e->name[0] != 'f'
+                 || (idx = atoi (e->name + 1)) < 0 || idx >= FILE_CNT)
+          fail ("unexpected entry \"%s\"", e->name);
+        if (seen[idx])
+          fail ("entry \"%s\" returned twice", e->name);
+        if (e->isdir != (idx == FILE_CNT))
+          fail ("entry \"%s\" has wrong type", e->name);
+        seen[idx] = true;
+        total++;
+      }
+  CHECK (n == 0, "getdents reached end of directory");
+  CHECK (total == FILE_CNT + 1, "read %d entries", FILE_CNT + 1);
+  CHECK (getdents (fd, entries, 7) == 0, "getdents after end");
+}
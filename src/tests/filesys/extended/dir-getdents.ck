@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(dir-getdents) begin
+(dir-getdents) mkdir "a"
+(dir-getdents) creating a/f0 through a/f19...
+(dir-getdents) mkdir "a/d"
+(dir-getdents) open "a"
+(dir-getdents) getdents 0 entries
+(dir-getdents) getdents reached end of directory
+(dir-getdents) read 21 entries
+(dir-getdents) getdents after end
+(dir-getdents) end
+EOF
+pass;
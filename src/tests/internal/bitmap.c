@@ -0,0 +1,175 @@
+/* Test program for lib/kernel/bitmap.c.
+
+   Checks bitmap_scan(), bitmap_count() and
+   bitmap_scan_and_flip_next() against straightforward bit-by-bit
+   reference implementations on randomly fragmented bitmaps, then
+   times the reference and library scans on a large bitmap.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/test.h"
+
+/* Largest bitmap checked for correctness. */
+#define MAX_BITS 300
+
+/* Size of the bitmap used for timing, and the number of scans
+   timed. */
+#define BENCH_BITS (1 << 16)
+#define BENCH_SCANS 64
+
+static void fragment (struct bitmap *, int density);
+static size_t ref_scan (const struct bitmap *, size_t start, size_t cnt,
+                        bool value);
+static size_t ref_count (const struct bitmap *, size_t start, size_t cnt,
+                         bool value);
+static void bench (int density, size_t cnt);
+
+/* Test the bitmap implementation. */
+void
+test (void) 
+{
+  size_t bit_cnt;
+
+  printf ("testing various size bitmaps:");
+  for (bit_cnt = 0; bit_cnt < MAX_BITS; bit_cnt += 7) 
+    {
+      int repeat;
+
+      printf (" %zu", bit_cnt);
+      for (repeat = 0; repeat < 10; repeat++) 
+        {
+          struct bitmap *b = bitmap_create (bit_cnt);
+          int i;
+
+          ASSERT (b != NULL);
+          fragment (b, repeat % 4 + 1);
+
+          /* Scans and counts from random positions. */
+          for (i = 0; i < 32; i++)
+            {
+              size_t start = random_ulong () % (bit_cnt + 1);
+              size_t cnt = random_ulong () % 12;
+              size_t len = random_ulong () % (bit_cnt - start + 1);
+              bool value = random_ulong () % 2;
+
+              ASSERT (bitmap_scan (b, start, cnt, value)
+                      == ref_scan (b, start, cnt, value));
+              ASSERT (bitmap_count (b, start, len, value)
+                      == ref_count (b, start, len, value));
+              ASSERT (bitmap_contains (b, start, len, value)
+                      == (ref_count (b, start, len, value) != 0));
+            }
+
+          /* Next-fit allocation succeeds exactly when some free
+             group exists, wherever the cursor is. */
+          for (i = 0; i < 16; i++)
+            {
+              size_t cnt = random_ulong () % 5 + 1;
+              bool found = ref_scan (b, 0, cnt, false) != BITMAP_ERROR;
+              size_t idx = bitmap_scan_and_flip_next (b, cnt, false);
+
+              ASSERT (found == (idx != BITMAP_ERROR));
+              ASSERT (!found || bitmap_all (b, idx, cnt));
+            }
+          bitmap_destroy (b);
+        }
+    }
+  printf (" done\n");
+
+  bench (2, 8);
+  bench (8, 8);
+  bench (32, 64);
+  printf ("bitmap: PASS\n");
+}
+
+/* Sets roughly one bit in DENSITY of B to false and the rest to
+   true, in runs of random length. */
+static void
+fragment (struct bitmap *b, int density) 
+{
+  size_t i = 0;
+
+  bitmap_set_all (b, true);
+  while (i < bitmap_size (b))
+    {
+      size_t run = random_ulong () % 8 + 1;
+      if (run > bitmap_size (b) - i)
+        run = bitmap_size (b) - i;
+      if (random_ulong () % density == 0)
+        bitmap_set_multiple (b, i, run, false);
+      i += run;
+    }
+}
+
+/* Reference bitmap_scan(): tries every start position, testing
+   bits one at a time. */
+static size_t
+ref_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) 
+{
+  size_t i, j;
+
+  for (i = start; i + cnt <= bitmap_size (b); i++)
+    {
+      for (j = 0; j < cnt; j++)
+        if (bitmap_test (b, i + j) != value)
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Reference bitmap_count(). */
+static size_t
+ref_count (const struct bitmap *b, size_t start, size_t cnt, bool value) 
+{
+  size_t i, value_cnt = 0;
+
+  for (i = 0; i < cnt; i++)
+    if (bitmap_test (b, start + i) == value)
+      value_cnt++;
+  return value_cnt;
+}
+
+/* Times BENCH_SCANS searches for CNT free bits, from random
+   start positions, in a BENCH_BITS-bit bitmap fragmented at
+   DENSITY, using both the reference and the library scan. */
+static void
+bench (int density, size_t cnt) 
+{
+  struct bitmap *b = bitmap_create (BENCH_BITS);
+  uint64_t ref_cycles = 0, lib_cycles = 0;
+  int i;
+
+  ASSERT (b != NULL);
+  fragment (b, density);
+  for (i = 0; i < BENCH_SCANS; i++)
+    {
+      size_t start = random_ulong () % BENCH_BITS;
+      uint64_t t0, t1, t2;
+      size_t ref_idx, lib_idx;
+
+      t0 = timer_cycles ();
+      ref_idx = ref_scan (b, start, cnt, false);
+      t1 = timer_cycles ();
+      lib_idx = bitmap_scan (b, start, cnt, false);
+      t2 = timer_cycles ();
+
+      ASSERT (ref_idx == lib_idx);
+      ref_cycles += t1 - t0;
+      lib_cycles += t2 - t1;
+    }
+  printf ("%d bits, 1/%d free, groups of %zu: "
+          "bit-at-a-time %llu cycles/scan, word-at-a-time %llu\n",
+          BENCH_BITS, density, cnt,
+          ref_cycles / BENCH_SCANS, lib_cycles / BENCH_SCANS);
+  bitmap_destroy (b);
+}
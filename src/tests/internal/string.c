@@ -0,0 +1,144 @@
+/* Benchmark for the block functions in lib/string.c.
+
+   Checks memcpy(), memmove(), memset() and memcmp() against
+   byte-at-a-time reference loops at every small size and
+   alignment, then reports throughput in MB/s of the reference
+   and library versions for copies and fills of 16 bytes through
+   4 kB.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/test.h"
+
+/* Bytes moved per size in the benchmark. */
+#define BENCH_BYTES (1024 * 1024)
+
+static unsigned char src[4096 + 64], dst[4096 + 64], ref[4096 + 64];
+
+static void check_sizes (void);
+static void byte_copy (unsigned char *, const unsigned char *, size_t);
+static void byte_set (unsigned char *, int, size_t);
+static void bench (const char *name, size_t size, bool fill);
+static unsigned mb_per_sec (uint64_t cycles);
+
+/* Test and time the block functions. */
+void
+test (void) 
+{
+  size_t size;
+
+  check_sizes ();
+  for (size = 16; size <= 4096; size *= 4)
+    {
+      bench ("copy", size, false);
+      bench ("fill", size, true);
+    }
+  printf ("string: PASS\n");
+}
+
+/* Compares the library functions with the reference loops for
+   sizes 0 through 96 at all combinations of source and
+   destination alignment. */
+static void
+check_sizes (void) 
+{
+  size_t size, s_ofs, d_ofs, i;
+
+  for (i = 0; i < sizeof src; i++)
+    src[i] = random_ulong ();
+
+  for (size = 0; size <= 96; size++)
+    for (s_ofs = 0; s_ofs < 4; s_ofs++)
+      for (d_ofs = 0; d_ofs < 4; d_ofs++)
+        {
+          memset (dst, 0x5a, sizeof dst);
+          memset (ref, 0x5a, sizeof ref);
+          ASSERT (memcpy (dst + d_ofs, src + s_ofs, size) == dst + d_ofs);
+          byte_copy (ref + d_ofs, src + s_ofs, size);
+          ASSERT (!memcmp (dst, ref, sizeof dst));
+
+          ASSERT (memset (dst + d_ofs, s_ofs, size) == dst + d_ofs);
+          byte_set (ref + d_ofs, s_ofs, size);
+          ASSERT (!memcmp (dst, ref, sizeof dst));
+
+          /* Overlapping moves in both directions. */
+          memcpy (dst, src, sizeof dst);
+          memcpy (ref, src, sizeof ref);
+          memmove (dst + 8 + d_ofs, dst + 8 + s_ofs, size);
+          memmove (ref + 8 + d_ofs, ref + 8 + s_ofs, size);
+          ASSERT (!memcmp (dst, ref, sizeof dst));
+
+          /* memcmp() sees a change to any byte. */
+          if (size > 0)
+            {
+              i = random_ulong () % size;
+              ref[s_ofs + i] ^= 1;
+              ASSERT ((memcmp (dst + s_ofs, ref + s_ofs, size) < 0)
+                      == (dst[s_ofs + i] < ref[s_ofs + i]));
+              ASSERT (memcmp (dst + s_ofs, ref + s_ofs, size) != 0);
+            }
+        }
+  printf ("checked sizes 0 through 96 at all alignments\n");
+}
+
+/* Reference copy. */
+static void
+byte_copy (unsigned char *d, const unsigned char *s, size_t size) 
+{
+  while (size-- > 0)
+    *d++ = *s++;
+}
+
+/* Reference fill. */
+static void
+byte_set (unsigned char *d, int value, size_t size) 
+{
+  while (size-- > 0)
+    *d++ = value;
+}
+
+/* Moves BENCH_BYTES bytes SIZE at a time, copying from SRC to
+   DST, or filling DST if FILL is true, with the reference loop
+   and then the library, and prints both rates. */
+static void
+bench (const char *name, size_t size, bool fill) 
+{
+  size_t reps = BENCH_BYTES / size;
+  uint64_t start, ref_cycles, lib_cycles;
+  size_t i;
+
+  start = timer_cycles ();
+  for (i = 0; i < reps; i++)
+    if (fill)
+      byte_set (dst, i, size);
+    else
+      byte_copy (dst, src, size);
+  ref_cycles = timer_cycles () - start;
+
+  start = timer_cycles ();
+  for (i = 0; i < reps; i++)
+    if (fill)
+      memset (dst, i, size);
+    else
+      memcpy (dst, src, size);
+  lib_cycles = timer_cycles () - start;
+
+  printf ("%s %4zu bytes: byte loop %u MB/s, library %u MB/s\n",
+          name, size, mb_per_sec (ref_cycles), mb_per_sec (lib_cycles));
+}
+
+/* Returns the rate, in MB/s, of moving BENCH_BYTES in CYCLES. */
+static unsigned
+mb_per_sec (uint64_t cycles) 
+{
+  int64_t nanos = timer_cycles_to_nanos (cycles);
+  return nanos > 0 ? (uint64_t) BENCH_BYTES * 1000 / nanos : 0;
+}
@@ -0,0 +1,100 @@
+/* Checks that readers share a readers-writer lock, by comparing
+   how long a group of readers that each sleep while holding the
+   lock take with a plain lock and with an rwlock.  Then checks
+   writer preference: a reader that arrives while a writer waits
+   for the readers already inside must wait for that writer. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define READER_CNT 5
+#define HOLD_TICKS 10
+
+static struct lock plain_lock;
+static struct rwlock rwlock;
+static struct semaphore done;
+
+static thread_func plain_reader;
+static thread_func rw_reader;
+static thread_func rw_writer;
+
+void
+test_rwlock_readers (void) 
+{
+  int64_t start, plain_ticks, rw_ticks;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&plain_lock);
+  rwlock_init (&rwlock);
+  sema_init (&done, 0);
+
+  start = timer_ticks ();
+  for (i = 0; i < READER_CNT; i++)
+    thread_create ("plain", PRI_DEFAULT + 1, plain_reader, NULL);
+  for (i = 0; i < READER_CNT; i++)
+    sema_down (&done);
+  plain_ticks = timer_elapsed (start);
+  msg ("plain lock: %d readers done.", READER_CNT);
+
+  start = timer_ticks ();
+  for (i = 0; i < READER_CNT; i++)
+    thread_create ("reader", PRI_DEFAULT + 1, rw_reader, NULL);
+  for (i = 0; i < READER_CNT; i++)
+    sema_down (&done);
+  rw_ticks = timer_elapsed (start);
+  msg ("rwlock: %d readers done.", READER_CNT);
+
+  if (rw_ticks * 2 >= plain_ticks)
+    fail ("readers took %lld ticks with rwlock, %lld with plain lock",
+          rw_ticks, plain_ticks);
+  msg ("rwlock readers ran concurrently.");
+
+  /* Reader A gets in first and sleeps.  The writer then waits for
+     it, so reader B, which arrives last, must wait for the
+     writer. */
+  thread_create ("reader A", PRI_DEFAULT + 1, rw_reader, "reader A");
+  thread_create ("writer", PRI_DEFAULT + 1, rw_writer, NULL);
+  thread_create ("reader B", PRI_DEFAULT + 1, rw_reader, "reader B");
+  for (i = 0; i < 3; i++)
+    sema_down (&done);
+}
+
+static void
+plain_reader (void *aux UNUSED) 
+{
+  lock_acquire (&plain_lock);
+  timer_sleep (HOLD_TICKS);
+  lock_release (&plain_lock);
+  sema_up (&done);
+}
+
+/* Holds RWLOCK for reading for a while, then reports as AUX, if
+   it is nonnull. */
+static void
+rw_reader (void *aux) 
+{
+  const char *name = aux;
+
+  rwlock_read_acquire (&rwlock);
+  timer_sleep (HOLD_TICKS);
+  if (name != NULL)
+    msg ("%s done.", name);
+  rwlock_read_release (&rwlock);
+  sema_up (&done);
+}
+
+static void
+rw_writer (void *aux UNUSED) 
+{
+  rwlock_write_acquire (&rwlock);
+  msg ("writer done.");
+  rwlock_write_release (&rwlock);
+  sema_up (&done);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-readers) begin
+(rwlock-readers) plain lock: 5 readers done.
+(rwlock-readers) rwlock: 5 readers done.
+(rwlock-readers) rwlock readers ran concurrently.
+(rwlock-readers) reader A done.
+(rwlock-readers) writer done.
+(rwlock-readers) reader B done.
+(rwlock-readers) end
+EOF
+pass;
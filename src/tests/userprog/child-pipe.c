@@ -0,0 +1,32 @@
+/* Child process run by pipe-inherit test.
+
+   Copies everything it can read from the file descriptor passed
+   as the first command-line argument into the pipe write end
+   passed as the second.  Both are inherited from the parent. */
+
+#include <stdlib.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-pipe";
+
+int
+main (int argc, char *argv[])
+{
+  char buf[64];
+  int in, out, n;
+
+  msg ("begin");
+  if (argc != 3)
+    fail ("bad command-line arguments");
+  in = atoi (argv[1]);
+  out = atoi (argv[2]);
+  while ((n = read (in, buf, sizeof buf)) > 0)
+    if (write (out, buf, n) != n)
+      fail ("write to pipe failed");
+  if (n < 0)
+    fail ("read from inherited descriptor failed");
+  msg ("end");
+
+  return 0;
+}
@@ -0,0 +1,32 @@
+/* Copies within "sample.txt" through two descriptors.  Copying
+   between overlapping ranges must return -1 and leave both
+   positions alone; copying between disjoint ones must work. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf[20];
+  int a, b;
+
+  CHECK ((a = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((b = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+
+  seek (b, 10);
+  CHECK (copy_file_range (a, b, 20) == -1,
+         "copy 0..20 to 10..30 (must return -1)");
+  CHECK (copy_file_range (b, a, 20) == -1,
+         "copy 10..30 to 0..20 (must return -1)");
+  CHECK (copy_file_range (a, a, 5) == -1,
+         "copy onto itself (must return -1)");
+  CHECK (tell (a) == 0 && tell (b) == 10, "positions unchanged");
+
+  seek (b, 100);
+  CHECK (copy_file_range (a, b, 20) == 20, "copy 0..20 to 100..120");
+  CHECK (pread (b, buf, 20, 100) == 20, "read back 100..120");
+  compare_bytes (buf, sample, 20, 100, "sample.txt");
+}
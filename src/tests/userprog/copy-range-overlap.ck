@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range-overlap) begin
+(copy-range-overlap) open "sample.txt"
+(copy-range-overlap) open "sample.txt" again
+(copy-range-overlap) copy 0..20 to 10..30 (must return -1)
+(copy-range-overlap) copy 10..30 to 0..20 (must return -1)
+(copy-range-overlap) copy onto itself (must return -1)
+(copy-range-overlap) positions unchanged
+(copy-range-overlap) copy 0..20 to 100..120
+(copy-range-overlap) read back 100..120
+(copy-range-overlap) end
+copy-range-overlap: exit(0)
+EOF
+pass;
@@ -0,0 +1,27 @@
+/* Copies "sample.txt" to a new file with copy_file_range() and
+   checks the copy. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  int size = sizeof sample - 1;
+  int in, out;
+
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("copy.txt", size), "create \"copy.txt\"");
+  CHECK ((out = open ("copy.txt")) > 1, "open \"copy.txt\"");
+  CHECK (copy_file_range (in, out, size) == size, "copy %d bytes", size);
+  CHECK (tell (in) == (unsigned) size && tell (out) == (unsigned) size,
+         "both positions advanced");
+  CHECK (copy_file_range (in, out, size) == 0, "copy at end of file");
+  CHECK (copy_file_range (STDIN_FILENO, out, size) == -1,
+         "copy from console (must return -1)");
+  close (out);
+  check_file ("copy.txt", sample, size);
+}
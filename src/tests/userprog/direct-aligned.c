@@ -0,0 +1,46 @@
+/* Writes and reads whole sectors of a file opened with O_DIRECT,
+   then reads them back through an ordinary descriptor. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE 2048
+
+/* Fills the SIZE bytes at BUF with a pattern that depends on
+   SEED. */
+static void
+fill (char *buf, size_t size, int seed)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    buf[i] = i * 7 + seed;
+}
+
+void
+test_main (void)
+{
+  static char data[SIZE], buf[SIZE];
+  int direct, plain;
+
+  fill (data, SIZE, 1);
+  CHECK (create ("data", SIZE), "create \"data\"");
+  CHECK (open_flags ("data", 0x100) == -1,
+         "open_flags with unknown flag (must return -1)");
+  CHECK ((direct = open_flags ("data", O_DIRECT)) > 1,
+         "open \"data\" with O_DIRECT");
+  CHECK (write (direct, data, SIZE) == SIZE, "direct write %d bytes", SIZE);
+  CHECK (tell (direct) == SIZE, "file position advanced");
+
+  seek (direct, 512);
+  CHECK (read (direct, buf, 1024) == 1024, "direct read 1024 bytes");
+  compare_bytes (buf, data + 512, 1024, 512, "data");
+  CHECK (read (direct, buf, SIZE) == 512, "direct read at end of file");
+  compare_bytes (buf, data + 1536, 512, 1536, "data");
+
+  CHECK ((plain = open ("data")) > 1, "open \"data\"");
+  CHECK (read (plain, buf, SIZE) == SIZE, "buffered read %d bytes", SIZE);
+  compare_bytes (buf, data, SIZE, 0, "data");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(direct-aligned) begin
+(direct-aligned) create "data"
+(direct-aligned) open_flags with unknown flag (must return -1)
+(direct-aligned) open "data" with O_DIRECT
+(direct-aligned) direct write 2048 bytes
+(direct-aligned) file position advanced
+(direct-aligned) direct read 1024 bytes
+(direct-aligned) direct read at end of file
+(direct-aligned) open "data"
+(direct-aligned) buffered read 2048 bytes
+(direct-aligned) end
+direct-aligned: exit(0)
+EOF
+pass;
@@ -0,0 +1,60 @@
+/* Alternates buffered and direct writes to the same sectors of a
+   file through two descriptors.  Each kind of read must see the
+   latest data, whichever way it was written. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE 1024
+
+/* Fills the SIZE bytes at BUF with a pattern that depends on
+   SEED. */
+static void
+fill (char *buf, size_t size, int seed)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    buf[i] = i * 7 + seed;
+}
+
+/* Reads all of FD from the start and compares it with DATA. */
+static void
+check_fd (int fd, const char *data, const char *how)
+{
+  static char buf[SIZE];
+
+  seek (fd, 0);
+  CHECK (read (fd, buf, SIZE) == SIZE, "%s read", how);
+  compare_bytes (buf, data, SIZE, 0, "data");
+}
+
+void
+test_main (void)
+{
+  static char data[SIZE];
+  int direct, plain;
+  int round;
+
+  CHECK (create ("data", SIZE), "create \"data\"");
+  CHECK ((plain = open ("data")) > 1, "open \"data\"");
+  CHECK ((direct = open_flags ("data", O_DIRECT)) > 1,
+         "open \"data\" with O_DIRECT");
+
+  for (round = 0; round < 2; round++)
+    {
+      fill (data, SIZE, 10 * round);
+      seek (plain, 0);
+      CHECK (write (plain, data, SIZE) == SIZE, "buffered write");
+      check_fd (direct, data, "direct");
+      check_fd (plain, data, "buffered");
+
+      fill (data, SIZE, 10 * round + 5);
+      seek (direct, 0);
+      CHECK (write (direct, data, SIZE) == SIZE, "direct write");
+      check_fd (plain, data, "buffered");
+      check_fd (direct, data, "direct");
+    }
+}
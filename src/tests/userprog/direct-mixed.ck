@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(direct-mixed) begin
+(direct-mixed) create "data"
+(direct-mixed) open "data"
+(direct-mixed) open "data" with O_DIRECT
+(direct-mixed) buffered write
+(direct-mixed) direct read
+(direct-mixed) buffered read
+(direct-mixed) direct write
+(direct-mixed) buffered read
+(direct-mixed) direct read
+(direct-mixed) buffered write
+(direct-mixed) direct read
+(direct-mixed) buffered read
+(direct-mixed) direct write
+(direct-mixed) buffered read
+(direct-mixed) direct read
+(direct-mixed) end
+direct-mixed: exit(0)
+EOF
+pass;
@@ -0,0 +1,59 @@
+/* Reads and writes a file opened with O_DIRECT at offsets and
+   sizes that are not whole sectors, and through a buffer that is
+   not aligned.  These must fall back to buffered I/O for the
+   partial sectors and still transfer every byte. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE 2048
+
+/* Fills the SIZE bytes at BUF with a pattern that depends on
+   SEED. */
+static void
+fill (char *buf, size_t size, int seed)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    buf[i] = i * 7 + seed;
+}
+
+void
+test_main (void)
+{
+  static char data[SIZE], buf[SIZE + 1];
+  int direct, plain;
+
+  fill (data, SIZE, 2);
+  CHECK (create ("data", SIZE), "create \"data\"");
+  CHECK ((direct = open_flags ("data", O_DIRECT)) > 1,
+         "open \"data\" with O_DIRECT");
+
+  /* One partial sector, then a run of whole ones and a tail. */
+  seek (direct, 100);
+  CHECK (write (direct, data + 100, 300) == 300,
+         "write 300 bytes at offset 100");
+  seek (direct, 0);
+  CHECK (write (direct, data, 100) == 100, "write 100 bytes at offset 0");
+  seek (direct, 400);
+  CHECK (write (direct, data + 400, 1500) == 1500,
+         "write 1500 bytes at offset 400");
+  CHECK (write (direct, data + 1900, 148) == 148,
+         "write 148 bytes at offset 1900");
+
+  seek (direct, 0);
+  CHECK (read (direct, buf + 1, 700) == 700,
+         "read 700 bytes into unaligned buffer");
+  compare_bytes (buf + 1, data, 700, 0, "data");
+  seek (direct, 333);
+  CHECK (read (direct, buf, SIZE) == SIZE - 333,
+         "read from offset 333 to end of file");
+  compare_bytes (buf, data + 333, SIZE - 333, 333, "data");
+
+  CHECK ((plain = open ("data")) > 1, "open \"data\"");
+  CHECK (read (plain, buf, SIZE) == SIZE, "buffered read %d bytes", SIZE);
+  compare_bytes (buf, data, SIZE, 0, "data");
+}
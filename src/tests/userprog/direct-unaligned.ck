@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(direct-unaligned) begin
+(direct-unaligned) create "data"
+(direct-unaligned) open "data" with O_DIRECT
+(direct-unaligned) write 300 bytes at offset 100
+(direct-unaligned) write 100 bytes at offset 0
+(direct-unaligned) write 1500 bytes at offset 400
+(direct-unaligned) write 148 bytes at offset 1900
+(direct-unaligned) read 700 bytes into unaligned buffer
+(direct-unaligned) read from offset 333 to end of file
+(direct-unaligned) open "data"
+(direct-unaligned) buffered read 2048 bytes
+(direct-unaligned) end
+direct-unaligned: exit(0)
+EOF
+pass;
@@ -0,0 +1,40 @@
+/* Redirects standard output, then standard input, to a pipe with
+   dup2(), and closes each to get the console back. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf[16];
+  int fds[2];
+
+  CHECK (pipe (fds), "pipe");
+
+  /* Nothing may print while output goes to the pipe. */
+  if (dup2 (fds[1], STDOUT_FILENO) != STDOUT_FILENO)
+    fail ("dup2 onto standard output failed");
+  write (STDOUT_FILENO, "to pipe", 7);
+  close (STDOUT_FILENO);
+  msg ("standard output restored");
+  CHECK (read (fds[0], buf, sizeof buf) == 7, "read redirected output");
+  if (memcmp (buf, "to pipe", 7))
+    fail ("pipe held wrong data");
+
+  CHECK (dup2 (fds[0], STDIN_FILENO) == STDIN_FILENO,
+         "dup2 onto standard input");
+  CHECK (write (fds[1], "input", 5) == 5, "write to pipe");
+  CHECK (read (STDIN_FILENO, buf, sizeof buf) == 5,
+         "read redirected input");
+  if (memcmp (buf, "input", 5))
+    fail ("standard input held wrong data");
+  close (STDIN_FILENO);
+
+  CHECK (dup2 (fds[1], fds[1]) == fds[1], "dup2 onto itself");
+  CHECK (dup2 (12345, STDOUT_FILENO) == -1,
+         "dup2 from bad descriptor (must return -1)");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(dup2-stdio) begin
+(dup2-stdio) pipe
+(dup2-stdio) standard output restored
+(dup2-stdio) read redirected output
+(dup2-stdio) dup2 onto standard input
+(dup2-stdio) write to pipe
+(dup2-stdio) read redirected input
+(dup2-stdio) dup2 onto itself
+(dup2-stdio) dup2 from bad descriptor (must return -1)
+(dup2-stdio) end
+dup2-stdio: exit(0)
+EOF
+pass;
@@ -0,0 +1,53 @@
+/* Sets up an I/O ring and submits a no-op on it, then an entry
+   with an unknown opcode.  The no-op must complete with 0 and
+   the other with -1, each carrying its submission's user_data. */
+
+#include <ioring.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define RING ((void *) 0x10000000)
+
+/* Queues an entry with OPCODE and USER_DATA on HDR's submission
+   queue. */
+static void
+submit (struct io_ring_hdr *hdr, enum io_op opcode, uint32_t user_data)
+{
+  struct io_sqe *sqe = &hdr->sq[hdr->sq_tail % IORING_SQ_ENTRIES];
+
+  sqe->opcode = opcode;
+  sqe->fd = -1;
+  sqe->buf = sqe->len = 0;
+  sqe->offset = 0;
+  sqe->user_data = user_data;
+  hdr->sq_tail++;
+}
+
+void
+test_main (void)
+{
+  struct io_ring_hdr *hdr = RING;
+  struct io_cqe *cqe;
+
+  CHECK (io_enter (1, 1) == -1, "io_enter without a ring (must return -1)");
+  CHECK (!io_setup ((char *) RING + 1, 1),
+         "io_setup at unaligned address (must fail)");
+  CHECK (!io_setup (RING, IORING_BUF_PAGES_MAX + 1),
+         "io_setup with too many pages (must fail)");
+  CHECK (io_setup (RING, 1), "io_setup");
+  CHECK (!io_setup (RING, 1), "second io_setup (must fail)");
+  CHECK (hdr->buf_size == 4096, "buffer area is one page");
+
+  submit (hdr, IO_OP_NOP, 42);
+  CHECK (io_enter (1, 1) == 1, "submit no-op");
+  CHECK (hdr->sq_head == 1 && hdr->cq_tail == 1, "no-op completed");
+  cqe = &hdr->cq[hdr->cq_head++ % IORING_CQ_ENTRIES];
+  CHECK (cqe->user_data == 42 && cqe->res == 0, "no-op result is 0");
+
+  submit (hdr, 99, 43);
+  CHECK (io_enter (1, 1) == 1, "submit unknown opcode");
+  cqe = &hdr->cq[hdr->cq_head++ % IORING_CQ_ENTRIES];
+  CHECK (hdr->cq_tail == 2 && cqe->user_data == 43 && cqe->res == -1,
+         "unknown opcode result is -1");
+}
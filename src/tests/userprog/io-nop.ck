@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(io-nop) begin
+(io-nop) io_enter without a ring (must return -1)
+(io-nop) io_setup at unaligned address (must fail)
+(io-nop) io_setup with too many pages (must fail)
+(io-nop) io_setup
+(io-nop) second io_setup (must fail)
+(io-nop) buffer area is one page
+(io-nop) submit no-op
+(io-nop) no-op completed
+(io-nop) no-op result is 0
+(io-nop) submit unknown opcode
+(io-nop) unknown opcode result is -1
+(io-nop) end
+io-nop: exit(0)
+EOF
+pass;
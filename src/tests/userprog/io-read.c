@@ -0,0 +1,78 @@
+/* Reads "sample.txt" into an I/O ring's buffer area, writes part
+   of it back at another offset, and submits a read that overruns
+   the buffer area, which must fail. */
+
+#include <ioring.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define RING ((void *) 0x10000000)
+#define BUF_PAGES 2
+
+/* Queues an entry on HDR's submission queue. */
+static void
+submit (struct io_ring_hdr *hdr, enum io_op opcode, int fd, uint32_t buf,
+        uint32_t len, int32_t offset, uint32_t user_data)
+{
+  struct io_sqe *sqe = &hdr->sq[hdr->sq_tail % IORING_SQ_ENTRIES];
+
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->buf = buf;
+  sqe->len = len;
+  sqe->offset = offset;
+  sqe->user_data = user_data;
+  hdr->sq_tail++;
+}
+
+/* Waits for one completion on HDR and returns its result,
+   failing unless it carries USER_DATA. */
+static int32_t
+reap (struct io_ring_hdr *hdr, uint32_t user_data)
+{
+  struct io_cqe *cqe;
+
+  if (hdr->cq_head == hdr->cq_tail)
+    io_enter (0, 1);
+  if (hdr->cq_head == hdr->cq_tail)
+    fail ("no completion for request %u", user_data);
+  cqe = &hdr->cq[hdr->cq_head++ % IORING_CQ_ENTRIES];
+  if (cqe->user_data != user_data)
+    fail ("completion for request %u, expected %u",
+          cqe->user_data, user_data);
+  return cqe->res;
+}
+
+void
+test_main (void)
+{
+  struct io_ring_hdr *hdr = RING;
+  char *bufs = (char *) RING + IORING_PAGES * 4096;
+  int size = sizeof sample - 1;
+  char expected[sizeof sample];
+  char buf[sizeof sample];
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (io_setup (RING, BUF_PAGES), "io_setup");
+
+  submit (hdr, IO_OP_READ, handle, 100, size, 0, 1);
+  CHECK (io_enter (1, 1) == 1, "submit read");
+  CHECK (reap (hdr, 1) == size, "read %d bytes", size);
+  compare_bytes (bufs + 100, sample, size, 0, "sample.txt");
+
+  submit (hdr, IO_OP_WRITE, handle, 100, 10, 50, 2);
+  CHECK (io_enter (1, 1) == 1, "submit write");
+  CHECK (reap (hdr, 2) == 10, "wrote 10 bytes");
+  memcpy (expected, sample, size);
+  memcpy (expected + 50, sample, 10);
+  CHECK (pread (handle, buf, size, 0) == size, "read back \"sample.txt\"");
+  compare_bytes (buf, expected, size, 0, "sample.txt");
+
+  submit (hdr, IO_OP_READ, handle, BUF_PAGES * 4096 - 10, 11, 0, 3);
+  CHECK (io_enter (1, 1) == 1, "submit read past buffer area");
+  CHECK (reap (hdr, 3) == -1, "read past buffer area (must return -1)");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(io-read) begin
+(io-read) open "sample.txt"
+(io-read) io_setup
+(io-read) submit read
+(io-read) read 239 bytes
+(io-read) submit write
+(io-read) wrote 10 bytes
+(io-read) read back "sample.txt"
+(io-read) submit read past buffer area
+(io-read) read past buffer area (must return -1)
+(io-read) end
+io-read: exit(0)
+EOF
+pass;
@@ -0,0 +1,28 @@
+/* Checks that a reader drains a pipe's data and then sees end of
+   file once the write end is closed, and that writing with no
+   read end open fails. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf[16];
+  int fds[2];
+
+  CHECK (pipe (fds), "pipe");
+  CHECK (write (fds[1], "abc", 3) == 3, "write 3 bytes");
+  close (fds[1]);
+  CHECK (read (fds[0], buf, sizeof buf) == 3, "read 3 bytes after close");
+  if (memcmp (buf, "abc", 3))
+    fail ("read wrong data");
+  CHECK (read (fds[0], buf, sizeof buf) == 0, "read at end of file");
+
+  CHECK (pipe (fds), "pipe");
+  close (fds[0]);
+  CHECK (write (fds[1], "abc", 3) == -1,
+         "write with no reader (must return -1)");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-eof) begin
+(pipe-eof) pipe
+(pipe-eof) write 3 bytes
+(pipe-eof) read 3 bytes after close
+(pipe-eof) read at end of file
+(pipe-eof) pipe
+(pipe-eof) write with no reader (must return -1)
+(pipe-eof) end
+pipe-eof: exit(0)
+EOF
+pass;
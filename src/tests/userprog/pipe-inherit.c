@@ -0,0 +1,41 @@
+/* Runs child-pipe, which inherits an open file and a pipe's
+   write end, and collects what it copies through the pipe.  The
+   child's copy of the file starts where the parent's is. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SKIP 10
+
+void
+test_main (void)
+{
+  char child_cmd[128];
+  char buf[sizeof sample];
+  int handle, fds[2];
+  int size = sizeof sample - 1 - SKIP;
+  int n, ofs;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (read (handle, buf, SKIP) == SKIP, "read %d bytes", SKIP);
+  CHECK (pipe (fds), "pipe");
+
+  snprintf (child_cmd, sizeof child_cmd, "child-pipe %d %d",
+            handle, fds[1]);
+  msg ("wait(exec()) = %d", wait (exec (child_cmd)));
+  close (fds[1]);
+
+  for (ofs = 0; (n = read (fds[0], buf + ofs, sizeof buf - ofs)) > 0; )
+    ofs += n;
+  if (ofs != size || memcmp (buf, sample + SKIP, size))
+    fail ("child copied %d bytes, expected %d", ofs, size);
+  msg ("child copied the rest of \"sample.txt\"");
+
+  CHECK (read (handle, buf, 1) == 1, "parent's position unaffected");
+  if (buf[0] != sample[SKIP])
+    fail ("parent read '%c', expected '%c'", buf[0], sample[SKIP]);
+}
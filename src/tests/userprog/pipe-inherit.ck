@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-inherit) begin
+(pipe-inherit) open "sample.txt"
+(pipe-inherit) read 10 bytes
+(pipe-inherit) pipe
+(child-pipe) begin
+(child-pipe) end
+child-pipe: exit(0)
+(pipe-inherit) wait(exec()) = 0
+(pipe-inherit) child copied the rest of "sample.txt"
+(pipe-inherit) parent's position unaffected
+(pipe-inherit) end
+pipe-inherit: exit(0)
+EOF
+pass;
@@ -0,0 +1,26 @@
+/* Writes to a pipe and reads the data back, then checks that
+   each end refuses the other's operation. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  static const char data[] = "through the pipe";
+  char buf[sizeof data];
+  int fds[2];
+
+  CHECK (pipe (fds), "pipe");
+  CHECK (fds[0] > 1 && fds[1] > 1 && fds[0] != fds[1],
+         "pipe returned two new descriptors");
+  CHECK (write (fds[1], data, sizeof data) == sizeof data, "write to pipe");
+  CHECK (read (fds[0], buf, sizeof buf) == sizeof buf, "read from pipe");
+  if (memcmp (buf, data, sizeof data))
+    fail ("read \"%s\", expected \"%s\"", buf, data);
+  CHECK (read (fds[1], buf, 1) == -1, "read from write end (must return -1)");
+  CHECK (write (fds[0], data, 1) == -1,
+         "write to read end (must return -1)");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-rw) begin
+(pipe-rw) pipe
+(pipe-rw) pipe returned two new descriptors
+(pipe-rw) write to pipe
+(pipe-rw) read from pipe
+(pipe-rw) read from write end (must return -1)
+(pipe-rw) write to read end (must return -1)
+(pipe-rw) end
+pipe-rw: exit(0)
+EOF
+pass;
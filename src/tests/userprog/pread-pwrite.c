@@ -0,0 +1,44 @@
+/* Reads and writes "sample.txt" at explicit offsets with pread()
+   and pwrite(), and checks that neither moves the file
+   position, and that pread() follows a standard input that
+   dup2() has pointed at the file. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char expected[sizeof sample];
+  char buf[sizeof sample];
+  int size = sizeof sample - 1;
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (pread (handle, buf, 20, 10) == 20, "pread 20 bytes at offset 10");
+  compare_bytes (buf, sample + 10, 20, 10, "sample.txt");
+
+  memcpy (expected, sample, sizeof sample);
+  memcpy (expected + 5, "XYZ", 3);
+  CHECK (pwrite (handle, "XYZ", 3, 5) == 3, "pwrite 3 bytes at offset 5");
+  CHECK (pread (handle, buf, size, 0) == size, "pread whole file");
+  compare_bytes (buf, expected, size, 0, "sample.txt");
+  CHECK (tell (handle) == 0, "file position unchanged");
+
+  CHECK (pread (handle, buf, sizeof buf, size) == 0, "pread at end of file");
+  CHECK (pread (handle, buf, 1, -1) == -1,
+         "pread at negative offset (must return -1)");
+  CHECK (pwrite (STDOUT_FILENO, "x", 1, 0) == -1,
+         "pwrite to console (must return -1)");
+
+  CHECK (dup2 (handle, STDIN_FILENO) == STDIN_FILENO,
+         "dup2 onto standard input");
+  CHECK (pread (STDIN_FILENO, buf, 20, 10) == 20,
+         "pread 20 bytes from redirected standard input");
+  compare_bytes (buf, expected + 10, 20, 10, "sample.txt");
+  close (STDIN_FILENO);
+}
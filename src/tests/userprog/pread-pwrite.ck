@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) open "sample.txt"
+(pread-pwrite) pread 20 bytes at offset 10
+(pread-pwrite) pwrite 3 bytes at offset 5
+(pread-pwrite) pread whole file
+(pread-pwrite) file position unchanged
+(pread-pwrite) pread at end of file
+(pread-pwrite) pread at negative offset (must return -1)
+(pread-pwrite) pwrite to console (must return -1)
+(pread-pwrite) dup2 onto standard input
+(pread-pwrite) pread 20 bytes from redirected standard input
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
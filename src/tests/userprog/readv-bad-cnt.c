@@ -0,0 +1,24 @@
+/* Passes readv() and writev() iovec counts that are negative or
+   too large.  Each call must return -1 without touching the
+   file. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf[16];
+  struct iovec iov = {buf, sizeof buf};
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (readv (handle, &iov, -1) == -1, "readv -1 buffers (must return -1)");
+  CHECK (readv (handle, &iov, 1025) == -1,
+         "readv 1025 buffers (must return -1)");
+  CHECK (writev (handle, &iov, -1) == -1,
+         "writev -1 buffers (must return -1)");
+  CHECK (readv (handle, &iov, 0) == 0, "readv 0 buffers");
+  CHECK (tell (handle) == 0, "file position unchanged");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-bad-cnt) begin
+(readv-bad-cnt) open "sample.txt"
+(readv-bad-cnt) readv -1 buffers (must return -1)
+(readv-bad-cnt) readv 1025 buffers (must return -1)
+(readv-bad-cnt) writev -1 buffers (must return -1)
+(readv-bad-cnt) readv 0 buffers
+(readv-bad-cnt) file position unchanged
+(readv-bad-cnt) end
+readv-bad-cnt: exit(0)
+EOF
+pass;
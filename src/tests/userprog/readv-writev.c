@@ -0,0 +1,29 @@
+/* Writes a file from several buffers with writev(), then reads it
+   back into buffers of other sizes with readv(). */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  static const char data[] = "abcdefgh";
+  struct iovec out[3] = {{(void *) "abc", 3}, {NULL, 0},
+                         {(void *) "defgh", 5}};
+  char head[5], tail[10];
+  struct iovec in[2] = {{head, sizeof head}, {tail, sizeof tail}};
+  int handle;
+
+  CHECK (create ("iov.txt", sizeof data - 1), "create \"iov.txt\"");
+  CHECK ((handle = open ("iov.txt")) > 1, "open \"iov.txt\"");
+  CHECK (writev (handle, out, 3) == 8, "writev 3 buffers");
+  CHECK (tell (handle) == 8, "file position advanced");
+
+  seek (handle, 0);
+  CHECK (readv (handle, in, 2) == 8, "readv into 2 buffers");
+  if (memcmp (head, data, 5) || memcmp (tail, data + 5, 3))
+    fail ("readv returned wrong data");
+  CHECK (readv (handle, in, 2) == 0, "readv at end of file");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) create "iov.txt"
+(readv-writev) open "iov.txt"
+(readv-writev) writev 3 buffers
+(readv-writev) file position advanced
+(readv-writev) readv into 2 buffers
+(readv-writev) readv at end of file
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
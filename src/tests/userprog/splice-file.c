@@ -0,0 +1,30 @@
+/* Moves a file into a pipe with splice(), then the pipe's
+   contents into a new file, and checks both copies.  Splicing
+   between two files must fail. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  int size = sizeof sample - 1;
+  int in, out, fds[2];
+
+  CHECK ((in = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (create ("copy.txt", size), "create \"copy.txt\"");
+  CHECK ((out = open ("copy.txt")) > 1, "open \"copy.txt\"");
+  CHECK (pipe (fds), "pipe");
+
+  CHECK (splice (in, fds[1], size) == size, "splice file into pipe");
+  CHECK (splice (fds[0], out, size) == size, "splice pipe into file");
+  close (fds[1]);
+  CHECK (splice (fds[0], out, size) == 0, "splice at end of pipe");
+  CHECK (splice (in, out, size) == -1,
+         "splice between files (must return -1)");
+
+  close (out);
+  check_file ("copy.txt", sample, size);
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(splice-file) begin
+(splice-file) open "sample.txt"
+(splice-file) create "copy.txt"
+(splice-file) open "copy.txt"
+(splice-file) pipe
+(splice-file) splice file into pipe
+(splice-file) splice pipe into file
+(splice-file) splice at end of pipe
+(splice-file) splice between files (must return -1)
+(splice-file) open "copy.txt" for verification
+(splice-file) verified contents of "copy.txt"
+(splice-file) close "copy.txt"
+(splice-file) end
+splice-file: exit(0)
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Child process run by shm-share test.
+
+   Attaches segment "seg" at an address of its own, checks the
+   parent's writes to its first page and fills its second. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+
+const char *test_name = "child-shm";
+
+#define SEG ((char *) 0x30000000)
+#define PAGE 4096
+
+int
+main (void)
+{
+  size_t i;
+
+  msg ("begin");
+  if (!shm_attach ("seg", SEG))
+    fail ("shm_attach \"seg\" failed");
+  for (i = 0; i < PAGE; i++)
+    if (SEG[i] != 'p')
+      fail ("parent's write not visible at byte %zu", i);
+  memset (SEG + PAGE, 'c', PAGE);
+  if (!shm_detach (SEG))
+    fail ("shm_detach failed");
+  msg ("end");
+
+  return 0;
+}
@@ -0,0 +1,41 @@
+/* Forks, then has the child overwrite memory it shares with the
+   parent copy-on-write.  The parent must not see the child's
+   writes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (64 * 1024)
+
+static char buf[SIZE];
+
+void
+test_main (void)
+{
+  pid_t pid;
+  int status;
+  size_t i;
+
+  memset (buf, 'p', sizeof buf);
+  pid = fork ();
+  if (pid == 0)
+    {
+      memset (buf, 'c', sizeof buf);
+      for (i = 0; i < SIZE; i++)
+        if (buf[i] != 'c')
+          fail ("child: byte %zu is %c, not c", i, buf[i]);
+      msg ("child: overwrote buffer");
+      exit (0);
+    }
+  /* Print nothing until the child is done, so that its output
+     always comes first. */
+  status = wait (pid);
+  CHECK (pid > 0, "fork");
+  CHECK (status == 0, "wait for child");
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != 'p')
+      fail ("parent sees child's write: byte %zu is %c", i, buf[i]);
+  msg ("parent's buffer unchanged");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-cow-child) begin
+(fork-cow-child) child: overwrote buffer
+fork-cow-child: exit(0)
+(fork-cow-child) fork
+(fork-cow-child) wait for child
+(fork-cow-child) parent's buffer unchanged
+(fork-cow-child) end
+fork-cow-child: exit(0)
+EOF
+pass;
@@ -0,0 +1,46 @@
+/* Forks, then has the parent overwrite memory it shares with the
+   child copy-on-write.  The child, which waits on a pipe until
+   the parent is done, must not see the parent's writes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (64 * 1024)
+
+static char buf[SIZE];
+
+void
+test_main (void)
+{
+  int fds[2];
+  pid_t pid;
+  size_t i;
+  char c;
+
+  CHECK (pipe (fds), "pipe");
+  memset (buf, 'p', sizeof buf);
+  pid = fork ();
+  if (pid == 0)
+    {
+      close (fds[1]);
+      if (read (fds[0], &c, 1) != 1)
+        fail ("child: read from pipe failed");
+      for (i = 0; i < SIZE; i++)
+        if (buf[i] != 'p')
+          fail ("child sees parent's write: byte %zu is %c", i, buf[i]);
+      msg ("child: buffer unchanged");
+      exit (0);
+    }
+  quiet = true;
+  CHECK (pid > 0, "fork");
+  memset (buf, 'q', sizeof buf);
+  CHECK (write (fds[1], "x", 1) == 1, "write to pipe");
+  quiet = false;
+  CHECK (wait (pid) == 0, "wait for child");
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != 'q')
+      fail ("parent lost its own write: byte %zu is %c", i, buf[i]);
+  msg ("parent's buffer overwritten");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-cow-parent) begin
+(fork-cow-parent) pipe
+(fork-cow-parent) child: buffer unchanged
+fork-cow-parent: exit(0)
+(fork-cow-parent) wait for child
+(fork-cow-parent) parent's buffer overwritten
+(fork-cow-parent) end
+fork-cow-parent: exit(0)
+EOF
+pass;
@@ -0,0 +1,25 @@
+/* Forks and checks that the child sees 0 as fork's return value
+   and that the parent gets back a process it can wait for. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  pid_t pid = fork ();
+  int status;
+
+  if (pid == 0)
+    {
+      msg ("child: fork returned 0");
+      exit (81);
+    }
+  /* Print nothing until the child is done, so that its output
+     always comes first. */
+  status = wait (pid);
+  CHECK (pid > 0, "fork");
+  CHECK (status == 81, "wait for child");
+  CHECK (wait (pid) == -1, "wait for child again (must return -1)");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-return) begin
+(fork-return) child: fork returned 0
+fork-return: exit(81)
+(fork-return) fork
+(fork-return) wait for child
+(fork-return) wait for child again (must return -1)
+(fork-return) end
+fork-return: exit(0)
+EOF
+pass;
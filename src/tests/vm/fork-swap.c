@@ -0,0 +1,71 @@
+/* Forks a process with more memory than fits in RAM alongside
+   its child.  The child touches enough other memory to push the
+   pages it shares copy-on-write with its parent out to swap,
+   then checks and overwrites them.  The parent must still see
+   its own data. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/arc4.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (1024 * 1024)
+
+static char shared[SIZE];
+static char scratch[SIZE];
+
+/* Fills BUF with the keystream for KEY. */
+static void
+fill (char *buf, const char *key)
+{
+  struct arc4 arc4;
+
+  memset (buf, 0, SIZE);
+  arc4_init (&arc4, key, strlen (key));
+  arc4_crypt (&arc4, buf, SIZE);
+}
+
+/* Returns true if BUF holds the keystream for KEY, by decrypting
+   it back to zeros. */
+static bool
+verify (char *buf, const char *key)
+{
+  struct arc4 arc4;
+  size_t i;
+
+  arc4_init (&arc4, key, strlen (key));
+  arc4_crypt (&arc4, buf, SIZE);
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != 0)
+      return false;
+  return true;
+}
+
+void
+test_main (void)
+{
+  pid_t pid;
+  int status;
+
+  fill (shared, "parent");
+  pid = fork ();
+  if (pid == 0)
+    {
+      /* Evict the shared pages, then fault them back in. */
+      fill (scratch, "child");
+      if (!verify (shared, "parent"))
+        fail ("child: shared pages corrupted after swap");
+      fill (shared, "child");
+      if (!verify (scratch, "child"))
+        fail ("child: scratch pages corrupted");
+      msg ("child: shared pages survived swap");
+      exit (0);
+    }
+  /* Print nothing until the child is done, so that its output
+     always comes first. */
+  status = wait (pid);
+  CHECK (pid > 0, "fork");
+  CHECK (status == 0, "wait for child");
+  CHECK (verify (shared, "parent"), "parent's pages unchanged");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-swap) begin
+(fork-swap) child: shared pages survived swap
+fork-swap: exit(0)
+(fork-swap) fork
+(fork-swap) wait for child
+(fork-swap) parent's pages unchanged
+(fork-swap) end
+fork-swap: exit(0)
+EOF
+pass;
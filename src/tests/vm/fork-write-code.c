@@ -0,0 +1,25 @@
+/* Forks a child that writes to the code segment it shares
+   read-only with its parent.  The child must be terminated with
+   -1 exit code, and the parent's code must be unharmed. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  pid_t pid = fork ();
+  int status;
+
+  if (pid == 0)
+    {
+      *(int *) test_main = 0;
+      fail ("child: writing the code segment succeeded");
+    }
+  /* Print nothing until the child is done, so that its output
+     always comes first. */
+  status = wait (pid);
+  CHECK (pid > 0, "fork");
+  CHECK (status == -1, "wait for child (must return -1)");
+}
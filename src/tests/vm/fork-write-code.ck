@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_USER_FAULTS => 1, [<<'EOF']);
+(fork-write-code) begin
+fork-write-code: exit(-1)
+(fork-write-code) fork
+(fork-write-code) wait for child (must return -1)
+(fork-write-code) end
+fork-write-code: exit(0)
+EOF
+pass;
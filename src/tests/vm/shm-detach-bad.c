@@ -0,0 +1,34 @@
+/* Passes shm_attach() and shm_detach() addresses and names that
+   do not match a segment.  Each must fail without disturbing the
+   segment that is attached. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SEG ((char *) 0x20000000)
+#define PAGE 4096
+
+void
+test_main (void)
+{
+  char *code = (char *) ((uintptr_t) test_main & ~(PAGE - 1));
+
+  CHECK (shm_create ("seg", 2 * PAGE), "shm_create \"seg\"");
+  CHECK (!shm_attach ("nothing", SEG),
+         "shm_attach missing segment (must fail)");
+  CHECK (!shm_attach ("seg", SEG + 1),
+         "shm_attach unaligned (must fail)");
+  CHECK (!shm_attach ("seg", code), "shm_attach over code (must fail)");
+  CHECK (shm_attach ("seg", SEG), "shm_attach \"seg\"");
+  SEG[0] = 'x';
+
+  CHECK (!shm_detach (SEG + PAGE),
+         "shm_detach inside segment (must fail)");
+  CHECK (!shm_detach (SEG + 16 * PAGE),
+         "shm_detach unattached address (must fail)");
+  CHECK (SEG[0] == 'x', "segment still attached");
+  CHECK (shm_detach (SEG), "shm_detach");
+  CHECK (!shm_detach (SEG), "shm_detach again (must fail)");
+}
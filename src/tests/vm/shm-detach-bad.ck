@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(shm-detach-bad) begin
+(shm-detach-bad) shm_create "seg"
+(shm-detach-bad) shm_attach missing segment (must fail)
+(shm-detach-bad) shm_attach unaligned (must fail)
+(shm-detach-bad) shm_attach over code (must fail)
+(shm-detach-bad) shm_attach "seg"
+(shm-detach-bad) shm_detach inside segment (must fail)
+(shm-detach-bad) shm_detach unattached address (must fail)
+(shm-detach-bad) segment still attached
+(shm-detach-bad) shm_detach
+(shm-detach-bad) shm_detach again (must fail)
+(shm-detach-bad) end
+shm-detach-bad: exit(0)
+EOF
+pass;
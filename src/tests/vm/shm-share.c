@@ -0,0 +1,34 @@
+/* Creates a two-page shared memory segment, fills the first page
+   and runs child-shm, which attaches the segment at another
+   address, checks the first page and fills the second.  The
+   parent must see the child's writes. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SEG ((char *) 0x20000000)
+#define PAGE 4096
+
+void
+test_main (void)
+{
+  size_t i;
+
+  CHECK (shm_create ("seg", 2 * PAGE), "shm_create \"seg\"");
+  CHECK (!shm_create ("seg", PAGE),
+         "shm_create \"seg\" again (must fail)");
+  CHECK (shm_attach ("seg", SEG), "shm_attach \"seg\"");
+  for (i = 0; i < 2 * PAGE; i++)
+    if (SEG[i] != 0)
+      fail ("new segment not zeroed at byte %zu", i);
+  memset (SEG, 'p', PAGE);
+
+  CHECK (wait (exec ("child-shm")) == 0, "wait for child-shm");
+  for (i = 0; i < PAGE; i++)
+    if (SEG[PAGE + i] != 'c')
+      fail ("child's write not visible at byte %zu", PAGE + i);
+  msg ("child's writes visible");
+  CHECK (shm_detach (SEG), "shm_detach");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(shm-share) begin
+(shm-share) shm_create "seg"
+(shm-share) shm_create "seg" again (must fail)
+(shm-share) shm_attach "seg"
+(child-shm) begin
+(child-shm) end
+child-shm: exit(0)
+(shm-share) wait for child-shm
+(shm-share) child's writes visible
+(shm-share) shm_detach
+(shm-share) end
+shm-share: exit(0)
+EOF
+pass;
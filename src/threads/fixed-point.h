@@ -0,0 +1,33 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 fixed-point arithmetic for the 4.4BSD scheduler.
+
+   A fixed-point number is an int whose low FP_SHIFT bits hold
+   the fraction.  X and Y below are fixed-point numbers and N is
+   an integer. */
+typedef int fixed_t;
+
+#define FP_SHIFT 14
+#define FP_F (1 << FP_SHIFT)
+
+/* Conversions. */
+#define FP_FROM_INT(N) ((fixed_t) ((N) * FP_F))
+#define FP_TO_INT_ZERO(X) ((X) / FP_F)                  /* Toward zero. */
+#define FP_TO_INT_NEAREST(X) ((X) >= 0                  /* To nearest. */ \
+                              ? ((X) + FP_F / 2) / FP_F                  \
+                              : ((X) - FP_F / 2) / FP_F)
+
+/* Arithmetic. */
+#define FP_ADD(X, Y) ((X) + (Y))
+#define FP_SUB(X, Y) ((X) - (Y))
+#define FP_ADD_INT(X, N) ((X) + (N) * FP_F)
+#define FP_SUB_INT(X, N) ((X) - (N) * FP_F)
+#define FP_MUL(X, Y) ((fixed_t) (((int64_t) (X)) * (Y) / FP_F))
+#define FP_MUL_INT(X, N) ((X) * (N))
+#define FP_DIV(X, Y) ((fixed_t) (((int64_t) (X)) * FP_F / (Y)))
+#define FP_DIV_INT(X, N) ((X) / (N))
+
+#endif /* threads/fixed-point.h */
@@ -18,7 +18,9 @@
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/palloc.h"
+#include "threads/profile.h"
 #include "threads/pte.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -31,6 +33,7 @@
 #endif
 #ifdef VM
 #include "vm/page.h"
+#include "vm/swap.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
@@ -89,7 +92,9 @@ main (void)
   /* Initialize memory system. */
   palloc_init ();
   malloc_init ();
+  slab_init ();
   paging_init ();
+  profile_init ();
 
   /* Segmentation. */
 #ifdef USERPROG
@@ -249,9 +254,28 @@ parse_options (char **argv)
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-nohz"))
+        timer_nohz = true;
+      else if (!strcmp (name, "-lockprof"))
+        lock_profiling = true;
+      else if (!strcmp (name, "-profile"))
+        {
+          profile_enabled = true;
+          if (value != NULL)
+            {
+              profile_pages = atoi (value);
+              if (value[strspn (value, "0123456789")] != '\0'
+                  || profile_pages == 0)
+                PANIC ("bad page count `%s' for -profile", value);
+            }
+        }
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-zswap"))
+        zswap_pages = atoi (value);
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -354,8 +378,14 @@ usage (void)
           "  -f                 Format file system disk during startup.\n"
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -nohz              Stop the timer tick while idle.\n"
+          "  -lockprof          Collect lock contention statistics.\n"
+          "  -profile[=PAGES]   Sample CPU usage into a PAGES-page buffer.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -zswap=PAGES       Keep up to PAGES of compressed swap in RAM.\n"
 #endif
           );
   power_off ();
@@ -392,6 +422,10 @@ print_stats (void)
 {
   timer_print_stats ();
   thread_print_stats ();
+  synch_print_stats ();
+  lock_print_stats ();
+  palloc_print_stats ();
+  slab_print_stats ();
 #ifdef FILESYS
   disk_print_stats ();
 #endif
@@ -399,5 +433,10 @@ print_stats (void)
   kbd_print_stats ();
 #ifdef USERPROG
   exception_print_stats ();
+  process_print_stats ();
+#endif
+#ifdef VM
+  swap_print_stats ();
 #endif
+  profile_dump ();
 }
@@ -353,6 +353,7 @@ intr_handler (struct intr_frame *frame)
 
       in_external_intr = true;
       yield_on_return = false;
+      timer_nohz_exit ();
     }
 
   /* Invoke the interrupt's handler. */
@@ -2,6 +2,7 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -24,14 +25,51 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Within a pool, free pages are managed by a binary buddy
+   allocator.  Free memory is kept as blocks of 2**ORDER pages,
+   each aligned (relative to the pool base) to its own size, on
+   one free list per order.  A request for PAGE_CNT pages takes a
+   block of the smallest sufficient order, splitting larger
+   blocks as needed, and gives any pages beyond PAGE_CNT back
+   right away so that odd-sized requests waste nothing.  Freeing
+   a block merges it with its buddy, the other half of the block
+   it was split from, for as long as that buddy is free as well.
+   Both operations take O(PALLOC_ORDERS) steps regardless of
+   pool size.
+
+   Free blocks are linked through their first bytes, so the only
+   extra bookkeeping is one byte per page recording the order of
+   the free block that starts there, if any.
+
+   A pool is protected by a spin lock rather than a struct lock
+   because schedule_tail() frees dying threads' pages with
+   interrupts off, where it cannot sleep. */
+
+/* Number of block orders, so the largest block is
+   2**(PALLOC_ORDERS - 1) pages. */
+#define PALLOC_ORDERS 16
+
+/* free_order[] value for a page that does not start a free block. */
+#define NOT_FREE 0xff
 
 /* A memory pool. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
+    struct spinlock lock;               /* Mutual exclusion. */
+    struct bitmap *used_map;            /* Bitmap of allocated pages. */
+    uint8_t *free_order;                /* Order of free block at each page. */
     uint8_t *base;                      /* Base of pool. */
+    const char *name;                   /* Name, for statistics. */
+    struct list free_lists[PALLOC_ORDERS]; /* Free blocks by order. */
+    size_t free_cnt[PALLOC_ORDERS];     /* Length of each free list. */
+  };
+
+/* A free block, at the start of its first page. */
+struct free_block
+  {
+    struct list_elem elem;              /* Element in a free list. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -43,6 +81,8 @@ size_t user_page_limit = SIZE_MAX;
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
 
 /* Initializes the page allocator. */
 void
@@ -84,9 +124,11 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  spinlock_acquire (&pool->lock);
+  page_idx = buddy_alloc (pool, page_cnt);
+  if (page_idx != BITMAP_ERROR)
+    bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+  spinlock_release (&pool->lock);
 
   if (page_idx != BITMAP_ERROR)
     pages = pool->base + PGSIZE * page_idx;
@@ -144,8 +186,11 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
+  spinlock_acquire (&pool->lock);
   ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
   bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  buddy_free (pool, page_idx, page_cnt);
+  spinlock_release (&pool->lock);
 }
 
 /* Frees the page at PAGE. */
@@ -160,10 +205,13 @@ palloc_free_page (void *page)
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
+  /* We'll put the pool's used_map and free_order array at its
+     base.  Calculate the space needed for them and subtract it
+     from the pool's size. */
+  size_t bm_size = bitmap_buf_size (page_cnt);
+  size_t bm_pages = DIV_ROUND_UP (bm_size + page_cnt, PGSIZE);
+  int order;
+
   if (bm_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
   page_cnt -= bm_pages;
@@ -171,9 +219,20 @@ init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
+  spinlock_init (&p->lock, name);
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_size);
+  p->free_order = (uint8_t *) base + bm_size;
+  memset (p->free_order, NOT_FREE, page_cnt);
   p->base = base + bm_pages * PGSIZE;
+  p->name = name;
+  for (order = 0; order < PALLOC_ORDERS; order++)
+    {
+      list_init (&p->free_lists[order]);
+      p->free_cnt[order] = 0;
+    }
+
+  /* Every page starts out free. */
+  buddy_free (p, 0, page_cnt);
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -187,3 +246,142 @@ page_from_pool (const struct pool *pool, void *page)
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the free block at page PAGE_IDX of POOL. */
+static struct free_block *
+idx_to_block (struct pool *pool, size_t page_idx)
+{
+  return (struct free_block *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Adds the block of 2**ORDER pages at PAGE_IDX to POOL's free
+   lists. */
+static void
+push_block (struct pool *pool, size_t page_idx, int order)
+{
+  ASSERT (pool->free_order[page_idx] == NOT_FREE);
+  pool->free_order[page_idx] = order;
+  list_push_front (&pool->free_lists[order],
+                   &idx_to_block (pool, page_idx)->elem);
+  pool->free_cnt[order]++;
+}
+
+/* Removes the free block at PAGE_IDX from POOL's free lists and
+   returns its order. */
+static int
+remove_block (struct pool *pool, size_t page_idx)
+{
+  int order = pool->free_order[page_idx];
+
+  ASSERT (order != NOT_FREE);
+  pool->free_order[page_idx] = NOT_FREE;
+  list_remove (&idx_to_block (pool, page_idx)->elem);
+  pool->free_cnt[order]--;
+  return order;
+}
+
+/* Frees the block of 2**ORDER pages at PAGE_IDX in POOL,
+   merging it with its buddy as long as the buddy is also a free
+   block of the same order. */
+static void
+free_block (struct pool *pool, size_t page_idx, int order)
+{
+  size_t page_cnt = bitmap_size (pool->used_map);
+
+  while (order < PALLOC_ORDERS - 1)
+    {
+      size_t buddy = page_idx ^ ((size_t) 1 << order);
+      if (buddy >= page_cnt || pool->free_order[buddy] != order)
+        break;
+      remove_block (pool, buddy);
+      if (buddy < page_idx)
+        page_idx = buddy;
+      order++;
+    }
+  push_block (pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX in POOL, which need not
+   form a single block, by splitting them into the largest
+   aligned blocks that fit. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, size_t page_cnt)
+{
+  while (page_cnt > 0)
+    {
+      int order = 0;
+      while (order < PALLOC_ORDERS - 1
+             && page_idx % ((size_t) 2 << order) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+      free_block (pool, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first one, or BITMAP_ERROR if no free block is
+   large enough.  POOL's lock must be held. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt)
+{
+  struct free_block *b;
+  int want, order;
+  size_t page_idx;
+
+  /* Smallest order that holds PAGE_CNT pages. */
+  for (want = 0; ((size_t) 1 << want) < page_cnt; want++)
+    if (want == PALLOC_ORDERS - 1)
+      return BITMAP_ERROR;
+
+  for (order = want; order < PALLOC_ORDERS; order++)
+    if (!list_empty (&pool->free_lists[order]))
+      break;
+  if (order == PALLOC_ORDERS)
+    return BITMAP_ERROR;
+
+  b = list_entry (list_front (&pool->free_lists[order]),
+                  struct free_block, elem);
+  page_idx = pg_no (b) - pg_no (pool->base);
+  remove_block (pool, page_idx);
+
+  /* Split off upper halves until the block is the size wanted. */
+  while (order > want)
+    {
+      order--;
+      push_block (pool, page_idx + ((size_t) 1 << order), order);
+    }
+
+  /* Give back the pages past PAGE_CNT. */
+  buddy_free (pool, page_idx + page_cnt, ((size_t) 1 << want) - page_cnt);
+  return page_idx;
+}
+
+/* Prints the number of free blocks of each order in POOL. */
+static void
+print_pool_stats (const struct pool *pool)
+{
+  size_t free_pages = 0;
+  int top, order;
+
+  for (top = PALLOC_ORDERS - 1; top > 0; top--)
+    if (pool->free_cnt[top] != 0)
+      break;
+  for (order = 0; order <= top; order++)
+    free_pages += pool->free_cnt[order] << order;
+
+  printf ("Palloc: %zu of %zu pages free in %s, free blocks by order:",
+          free_pages, bitmap_size (pool->used_map), pool->name);
+  for (order = 0; order <= top; order++)
+    printf (" %zu", pool->free_cnt[order]);
+  printf ("\n");
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void)
+{
+  print_pool_stats (&kernel_pool);
+  print_pool_stats (&user_pool);
+}
@@ -0,0 +1,110 @@
+#include "threads/profile.h"
+#include <debug.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+/* Sampling CPU profiler.
+
+   On every timer tick, profile_sample() records the interrupted
+   eip, the running thread and whether it was in user mode, plus
+   the return addresses of up to PROFILE_DEPTH - 1 callers found
+   by following saved frame pointers on a kernel stack.  Samples
+   go into a ring buffer allocated at boot, so the oldest are
+   overwritten once it fills.  profile_dump() prints them at
+   shutdown for "backtrace --profile" to symbolize. */
+bool profile_enabled;
+size_t profile_pages = 32;
+
+#define PROFILE_DEPTH 8
+
+struct sample
+  {
+    int tid;                            /* Running thread. */
+    uint8_t user;                       /* Interrupted in user mode? */
+    uint8_t depth;                      /* # of valid PCS. */
+    uint32_t pcs[PROFILE_DEPTH];        /* eip, then callers. */
+  };
+
+static struct sample *samples;  /* Ring buffer. */
+static size_t sample_cnt;       /* Capacity of samples. */
+static long long sample_total;  /* # of samples taken. */
+
+/* Allocates the sample buffer, if profiling is enabled. */
+void
+profile_init (void)
+{
+  if (!profile_enabled)
+    return;
+
+  samples = palloc_get_multiple (0, profile_pages);
+  if (samples == NULL)
+    PANIC ("profile: cannot allocate %zu pages", profile_pages);
+  sample_cnt = profile_pages * PGSIZE / sizeof *samples;
+}
+
+/* Records a sample of the code interrupted by the timer, whose
+   state is in F.  Runs in the timer interrupt handler. */
+void
+profile_sample (const struct intr_frame *f)
+{
+  struct thread *t = thread_current ();
+  struct sample *s;
+
+  if (samples == NULL)
+    return;
+
+  s = &samples[sample_total++ % sample_cnt];
+  s->tid = t->tid;
+  s->user = (f->cs & 3) == 3;
+  s->pcs[0] = (uint32_t) f->eip;
+  s->depth = 1;
+
+  /* Walk the kernel stack, which is confined to T's page, so a
+     damaged frame pointer cannot take us elsewhere. */
+  if (!s->user)
+    {
+      uint32_t *frame = (uint32_t *) f->ebp;
+      uint32_t *lo = (uint32_t *) t;
+      uint32_t *hi = (uint32_t *) ((uint8_t *) t + PGSIZE);
+
+      while (s->depth < PROFILE_DEPTH
+             && frame > lo && frame + 2 <= hi && frame[1] != 0)
+        {
+          s->pcs[s->depth++] = frame[1];
+          if ((uint32_t *) frame[0] <= frame)
+            break;
+          frame = (uint32_t *) frame[0];
+        }
+    }
+}
+
+/* Prints the samples in the ring buffer, oldest first, one per
+   line: "PS TID MODE EIP CALLER...", with MODE K or U. */
+void
+profile_dump (void)
+{
+  long long first, i;
+
+  if (samples == NULL)
+    return;
+
+  first = sample_total > (long long) sample_cnt
+          ? sample_total - (long long) sample_cnt : 0;
+  printf ("Profile: %lld samples, %lld kept, %d Hz\n",
+          sample_total, sample_total - first, TIMER_FREQ);
+  for (i = first; i < sample_total; i++)
+    {
+      const struct sample *s = &samples[i % sample_cnt];
+      int d;
+
+      printf ("PS %d %c", s->tid, s->user ? 'U' : 'K');
+      for (d = 0; d < s->depth; d++)
+        printf (" %#x", s->pcs[d]);
+      printf ("\n");
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef THREADS_PROFILE_H
+#define THREADS_PROFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct intr_frame;
+
+/* Sampling CPU profiler.  Enabled by kernel command-line option
+   "-profile", optionally "-profile=PAGES" to size its buffer. */
+extern bool profile_enabled;
+extern size_t profile_pages;
+
+void profile_init (void);
+void profile_sample (const struct intr_frame *);
+void profile_dump (void);
+
+#endif /* threads/profile.h */
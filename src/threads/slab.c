@@ -0,0 +1,260 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* A slab allocator.
+
+   A slab is one page from the kernel pool.  It begins with a
+   struct slab header, followed by the cache's objects packed at
+   the cache's stride.  Free objects within a slab are threaded
+   onto a singly linked list through their first word, so an
+   object costs nothing beyond its (aligned) size.
+
+   Because a slab is exactly one page, the slab that owns an
+   object is found by rounding the object's address down to a
+   page boundary, just as malloc() finds its arenas.
+
+   Allocation prefers partially used slabs, so that objects pack
+   into as few pages as possible, then a retained empty slab,
+   and only then a fresh page.  When a slab becomes empty it is
+   kept if the cache holds fewer than SLAB_EMPTY_MAX empty slabs
+   and returned to palloc otherwise. */
+
+/* Empty slabs a cache keeps instead of freeing. */
+#define SLAB_EMPTY_MAX 2
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* Slab header, at the start of each slab's page. */
+struct slab
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct slab_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in one of the cache's lists. */
+    size_t in_use;              /* Allocated objects. */
+    struct free_obj *free;      /* First free object. */
+  };
+
+/* A free object. */
+struct free_obj
+  {
+    struct free_obj *next;
+  };
+
+/* All initialized caches, for slab_print_stats(). */
+static struct list all_caches;
+
+static struct slab *slab_create (struct slab_cache *);
+static struct slab *obj_to_slab (struct slab_cache *, void *);
+
+/* Initializes the slab allocator. */
+void
+slab_init (void)
+{
+  list_init (&all_caches);
+}
+
+/* Initializes cache C to hand out objects of SIZE bytes aligned
+   on ALIGN-byte boundaries.  ALIGN must be a power of 2; 0 means
+   pointer alignment.  NAME identifies the cache in statistics
+   and must remain valid for the life of the cache. */
+void
+slab_cache_init (struct slab_cache *c, const char *name,
+                 size_t size, size_t align)
+{
+  enum intr_level old_level;
+
+  if (align < sizeof (void *))
+    align = sizeof (void *);
+  ASSERT ((align & (align - 1)) == 0);
+  ASSERT (size > 0);
+
+  c->name = name;
+  c->obj_size = size;
+  c->stride = ROUND_UP (size < sizeof (struct free_obj)
+                        ? sizeof (struct free_obj) : size, align);
+  c->first_ofs = ROUND_UP (sizeof (struct slab), align);
+  ASSERT (c->first_ofs + c->stride <= PGSIZE);
+  c->objs_per_slab = (PGSIZE - c->first_ofs) / c->stride;
+
+  lock_init_named (&c->lock, name);
+  list_init (&c->partial);
+  list_init (&c->full);
+  list_init (&c->empty);
+  c->empty_cnt = 0;
+
+  c->in_use = c->peak = c->slab_cnt = 0;
+  c->allocs = c->grows = c->reaps = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&all_caches, &c->elem);
+  intr_set_level (old_level);
+}
+
+/* Obtains and returns a new object from cache C.
+   Returns a null pointer if memory is not available.  The
+   object's contents are unspecified. */
+void *
+slab_alloc (struct slab_cache *c)
+{
+  struct slab *s;
+  struct free_obj *o;
+
+  lock_acquire (&c->lock);
+
+  if (!list_empty (&c->partial))
+    s = list_entry (list_front (&c->partial), struct slab, elem);
+  else if (!list_empty (&c->empty))
+    {
+      s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+      c->empty_cnt--;
+      list_push_front (&c->partial, &s->elem);
+    }
+  else
+    {
+      s = slab_create (c);
+      if (s == NULL)
+        {
+          lock_release (&c->lock);
+          return NULL;
+        }
+      list_push_front (&c->partial, &s->elem);
+    }
+
+  /* Take an object from the slab. */
+  o = s->free;
+  ASSERT (o != NULL);
+  s->free = o->next;
+  if (++s->in_use == c->objs_per_slab)
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->full, &s->elem);
+    }
+
+  c->allocs++;
+  if (++c->in_use > c->peak)
+    c->peak = c->in_use;
+  lock_release (&c->lock);
+  return o;
+}
+
+/* Returns object P, which must have been allocated from cache C
+   with slab_alloc(), to C.  A null P is ignored. */
+void
+slab_free (struct slab_cache *c, void *p)
+{
+  struct slab *s;
+  struct free_obj *o = p;
+
+  if (p == NULL)
+    return;
+  s = obj_to_slab (c, p);
+
+#ifndef NDEBUG
+  /* Clear the object to help detect use-after-free bugs. */
+  memset (p, 0xcc, c->obj_size);
+#endif
+
+  lock_acquire (&c->lock);
+  ASSERT (s->in_use > 0);
+
+  o->next = s->free;
+  s->free = o;
+  c->in_use--;
+
+  if (s->in_use-- == c->objs_per_slab)
+    {
+      /* Was full. */
+      list_remove (&s->elem);
+      list_push_front (&c->partial, &s->elem);
+    }
+  if (s->in_use == 0)
+    {
+      list_remove (&s->elem);
+      if (c->empty_cnt < SLAB_EMPTY_MAX)
+        {
+          list_push_front (&c->empty, &s->elem);
+          c->empty_cnt++;
+        }
+      else
+        {
+          s->magic = 0;
+          palloc_free_page (s);
+          c->slab_cnt--;
+          c->reaps++;
+        }
+    }
+
+  lock_release (&c->lock);
+}
+
+/* Prints statistics for every cache that has been used. */
+void
+slab_print_stats (void)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&all_caches); e != list_end (&all_caches);
+       e = list_next (e))
+    {
+      struct slab_cache *c = list_entry (e, struct slab_cache, elem);
+      if (c->allocs == 0)
+        continue;
+      printf ("Slab %s: %zu of %zu objects in use (peak %zu), "
+              "%zu slabs, %lld grown, %lld reaped, %zu bytes/object\n",
+              c->name, c->in_use, c->slab_cnt * c->objs_per_slab,
+              c->peak, c->slab_cnt, c->grows, c->reaps, c->stride);
+    }
+}
+
+/* Obtains a page for cache C and threads all of its objects onto
+   the slab's free list.  Returns a null pointer if no page is
+   available.  C's lock must be held. */
+static struct slab *
+slab_create (struct slab_cache *c)
+{
+  struct slab *s;
+  size_t i;
+
+  s = palloc_get_page (0);
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->in_use = 0;
+  s->free = NULL;
+  for (i = c->objs_per_slab; i-- > 0; )
+    {
+      struct free_obj *o = (struct free_obj *) ((uint8_t *) s + c->first_ofs
+                                                + i * c->stride);
+      o->next = s->free;
+      s->free = o;
+    }
+
+  c->slab_cnt++;
+  c->grows++;
+  return s;
+}
+
+/* Returns the slab that contains object P of cache C. */
+static struct slab *
+obj_to_slab (struct slab_cache *c, void *p)
+{
+  struct slab *s = pg_round_down (p);
+
+  /* Check that the slab is valid and P is an object boundary. */
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+  ASSERT (pg_ofs (p) >= c->first_ofs
+          && (pg_ofs (p) - c->first_ofs) % c->stride == 0);
+
+  return s;
+}
@@ -0,0 +1,51 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <list.h>
+#include <stddef.h>
+#include "threads/synch.h"
+
+/* An object cache.
+
+   Hands out fixed-size objects carved from single pages ("slabs")
+   obtained from the page allocator.  Each slab is on exactly one
+   of the cache's partial, full or empty lists.  Up to
+   SLAB_EMPTY_MAX empty slabs are kept around so that a workload
+   that repeatedly allocates and frees one object does not bounce
+   a page in and out of palloc every time.
+
+   The owner declares a struct slab_cache, usually static, and
+   initializes it with slab_cache_init() before first use. */
+struct slab_cache
+  {
+    const char *name;           /* Name, for statistics. */
+    size_t obj_size;            /* Requested object size. */
+    size_t stride;              /* Object size rounded up to alignment. */
+    size_t first_ofs;           /* Page offset of the first object. */
+    size_t objs_per_slab;       /* Objects in one slab. */
+
+    struct lock lock;           /* Protects everything below. */
+    struct list partial;        /* Slabs with some objects free. */
+    struct list full;           /* Slabs with no objects free. */
+    struct list empty;          /* Slabs with every object free. */
+    size_t empty_cnt;           /* Number of slabs on EMPTY. */
+
+    /* Statistics. */
+    size_t in_use;              /* Objects currently allocated. */
+    size_t peak;                /* Maximum of IN_USE. */
+    size_t slab_cnt;            /* Slabs currently held. */
+    long long allocs;           /* Calls to slab_alloc(). */
+    long long grows;            /* Slabs obtained from palloc. */
+    long long reaps;            /* Slabs returned to palloc. */
+
+    struct list_elem elem;      /* Element in list of all caches. */
+  };
+
+void slab_init (void);
+void slab_cache_init (struct slab_cache *, const char *name,
+                      size_t size, size_t align);
+void *slab_alloc (struct slab_cache *);
+void slab_free (struct slab_cache *, void *);
+void slab_print_stats (void);
+
+#endif /* threads/slab.h */
@@ -32,6 +32,52 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Priority donation.
+
+   A thread that blocks on a semaphore with a known owner donates
+   its priority to that owner, and if the owner is itself blocked,
+   onward along the chain, but never more than DONATE_DEPTH links
+   so that the cost of blocking stays bounded.  Each semaphore
+   remembers the highest priority among its waiters, so dropping a
+   donation when ownership ends only needs to look at the
+   semaphores the owner still holds. */
+#define DONATE_DEPTH 8
+
+/* Priority inversions: times a thread blocked on a semaphore
+   whose owner had lower priority. */
+static long long inversion_cnt;
+static int64_t inversion_total_ns;
+static int64_t inversion_max_ns;
+
+static void donate (struct semaphore *, int priority);
+
+/* Lock contention profiler.
+
+   Locks initialized with the same name, such as every instance of
+   a lock embedded in some structure, share one entry. */
+bool lock_profiling;
+
+struct lock_stats
+  {
+    const char *name;           /* Name given to lock_init(). */
+    long long acquires;         /* # of acquisitions. */
+    long long contended;        /* # that had to wait. */
+    int64_t wait_total_ns;      /* Time spent waiting. */
+    int64_t wait_max_ns;
+    int64_t hold_total_ns;      /* Time spent holding. */
+    int64_t hold_max_ns;
+  };
+
+#define LOCK_STATS_MAX 64
+static struct lock_stats lock_stats[LOCK_STATS_MAX];
+static int lock_stats_cnt;
+static long long lock_stats_dropped;    /* Locks with no free entry. */
+
+static void lock_stats_acquired (struct lock_stats *, int64_t wait,
+                                 bool contended);
+static void lock_stats_released (struct lock_stats *, int64_t hold);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -49,6 +95,8 @@ sema_init (struct semaphore *sema, unsigned value)
 
   sema->value = value;
   list_init (&sema->waiters);
+  sema->owner = NULL;
+  sema->donation = -1;
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -70,10 +118,95 @@ sema_down (struct semaphore *sema)
   old_level = intr_disable ();
   while (sema->value == 0) 
     {
-      list_push_back (&sema->waiters, &thread_current ()->elem);
+      struct thread *cur = thread_current ();
+
+      list_push_back (&sema->waiters, &cur->elem);
+      cur->blocked_on = sema;
+      if (!thread_mlfqs)
+        {
+          if (sema->owner != NULL && sema->owner->priority < cur->priority
+              && cur->inversion_start == 0)
+            cur->inversion_start = timer_nanos () | 1;
+          donate (sema, cur->priority);
+        }
       thread_block ();
+      cur->blocked_on = NULL;
     }
   sema->value--;
+
+  if (thread_current ()->inversion_start != 0)
+    {
+      int64_t ns = timer_nanos () - thread_current ()->inversion_start;
+      thread_current ()->inversion_start = 0;
+      inversion_cnt++;
+      inversion_total_ns += ns;
+      if (ns > inversion_max_ns)
+        inversion_max_ns = ns;
+    }
+  intr_set_level (old_level);
+}
+
+/* Has waiters on SEMA donate PRIORITY to its owner and, if that
+   owner is blocked in turn, to the owner of what it waits for,
+   up to DONATE_DEPTH semaphores deep. */
+static void
+donate (struct semaphore *sema, int priority)
+{
+  int depth;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (depth = 0; sema != NULL && depth < DONATE_DEPTH; depth++)
+    {
+      struct thread *owner = sema->owner;
+
+      if (sema->donation < priority)
+        sema->donation = priority;
+      if (owner == NULL || owner->priority >= priority)
+        break;
+      thread_update_priority (owner, priority);
+      sema = owner->blocked_on;
+    }
+}
+
+/* Makes T the owner of SEMA: the thread expected to up it, to
+   which threads waiting on SEMA donate their priority.  SEMA must
+   not already have an owner. */
+void
+sema_set_owner (struct semaphore *sema, struct thread *t)
+{
+  enum intr_level old_level;
+
+  ASSERT (sema != NULL);
+  ASSERT (t != NULL);
+
+  old_level = intr_disable ();
+  ASSERT (sema->owner == NULL);
+  sema->owner = t;
+  list_push_back (&t->held, &sema->owner_elem);
+  if (!thread_mlfqs && sema->donation > t->priority)
+    thread_update_priority (t, sema->donation);
+  intr_set_level (old_level);
+}
+
+/* Ends the ownership of SEMA, if any, withdrawing the donations
+   its waiters made to the owner. */
+void
+sema_clear_owner (struct semaphore *sema)
+{
+  enum intr_level old_level;
+  struct thread *owner;
+
+  ASSERT (sema != NULL);
+
+  old_level = intr_disable ();
+  owner = sema->owner;
+  if (owner != NULL)
+    {
+      list_remove (&sema->owner_elem);
+      sema->owner = NULL;
+      thread_refresh_priority (owner);
+    }
   intr_set_level (old_level);
 }
 
@@ -126,16 +259,35 @@ sema_up (struct semaphore *sema)
   ASSERT (sema != NULL);
  
   old_level = intr_disable ();
+  sema->donation = -1;
   if (!list_empty (&sema->waiters))
     {
-      e = list_max(&sema->waiters, comp_priority, NULL);
-      t = list_entry(e, struct thread, elem);
-      list_remove(e);
-      thread_unblock(t);
+      /* Find the highest-priority waiter to wake and, in the same
+         pass, the highest priority among those that stay. */
+      t = list_entry (list_front (&sema->waiters), struct thread, elem);
+      for (e = list_next (list_front (&sema->waiters));
+           e != list_end (&sema->waiters); e = list_next (e))
+        {
+          struct thread *w = list_entry (e, struct thread, elem);
+          if (w->priority > t->priority)
+            {
+              sema->donation = t->priority;
+              t = w;
+            }
+          else if (w->priority > sema->donation)
+            sema->donation = w->priority;
+        }
+      list_remove (&t->elem);
+      thread_unblock (t);
     }
   sema->value++;
-  if(t && thread_current()->priority < t->priority)
-      thread_yield();
+  if (t != NULL && thread_current ()->priority < t->priority)
+    {
+      if (intr_context ())
+        intr_yield_on_return ();
+      else
+        thread_yield ();
+    }
   intr_set_level (old_level);
 }
 
@@ -192,13 +344,33 @@ sema_test_helper (void *sema_)
    onerous, it's a good sign that a semaphore should be used,
    instead of a lock. */
 void
-lock_init (struct lock *lock)
+lock_init_named (struct lock *lock, const char *name)
 {
   ASSERT (lock != NULL);
+  ASSERT (name != NULL);
 
   lock->holder = NULL;
-  lock->trier_ptr = NULL;
+  lock->stats = NULL;
   sema_init (&lock->semaphore, 1);
+
+  if (lock_profiling)
+    {
+      enum intr_level old_level = intr_disable ();
+      int i;
+
+      if (*name == '&')
+        name++;
+      for (i = 0; i < lock_stats_cnt; i++)
+        if (!strcmp (lock_stats[i].name, name))
+          break;
+      if (i == lock_stats_cnt && lock_stats_cnt < LOCK_STATS_MAX)
+        lock_stats[lock_stats_cnt++].name = name;
+      if (i < lock_stats_cnt)
+        lock->stats = &lock_stats[i];
+      else
+        lock_stats_dropped++;
+      intr_set_level (old_level);
+    }
 }
 /*
    necessary.  The lock must not already be held by the current
@@ -211,47 +383,26 @@ lock_init (struct lock *lock)
 void
 lock_acquire (struct lock *lock)
 {
-  struct thread *holder = lock->holder;
-  struct thread *trier = thread_current();
-  struct thread *donator_prev;
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
-  if(holder && holder->priority < trier->priority)
-  {
-      donator_prev = (lock->trier_ptr == NULL) ? NULL : list_entry(lock->trier_ptr, struct thread, donate_elem);
-
-      if(donator_prev != NULL)
-      {
-          donator_prev->donatee = NULL;
-          holder->priority = trier->priority;
-          list_remove(lock->trier_ptr);
-          lock->trier_ptr = &trier->donate_elem;
-          list_push_back(&holder->donator, lock->trier_ptr);
-      }
-      else
-      {
-        if(holder->priority_before == -1)
-           holder->priority_before = holder->priority;
-
-        holder->priority = trier->priority;
-
-        lock->trier_ptr = &trier->donate_elem;
-        list_push_back(&holder->donator, lock->trier_ptr);
-      }
-
-      trier->donatee = holder;
-      while(holder->donatee)
-      {
-          holder->donatee->priority = trier->priority;
-          holder = holder->donatee;
-      }
-;
-  }
+  /* While we wait, sema_down() donates our priority to the
+     holder, which owns the semaphore. */
+  if (lock->stats != NULL)
+    {
+      struct lock_stats *ls = lock->stats;
+      int64_t start = timer_nanos ();
+      bool contended = lock->holder != NULL;
 
-  sema_down (&lock->semaphore);
-  lock->holder = trier;
+      sema_down (&lock->semaphore);
+      lock->acquired = timer_nanos ();
+      lock_stats_acquired (ls, lock->acquired - start, contended);
+    }
+  else
+    sema_down (&lock->semaphore);
+  lock->holder = thread_current ();
+  sema_set_owner (&lock->semaphore, lock->holder);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -270,7 +421,15 @@ lock_try_acquire (struct lock *lock)
 
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+      lock->holder = thread_current ();
+      sema_set_owner (&lock->semaphore, lock->holder);
+      if (lock->stats != NULL)
+        {
+          lock->acquired = timer_nanos ();
+          lock_stats_acquired (lock->stats, 0, false);
+        }
+    }
   return success;
 }
 
@@ -283,28 +442,49 @@ lock_try_acquire (struct lock *lock)
 void
 lock_release (struct lock *lock) 
 {
-  struct thread *holder = lock->holder;
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
-  if(lock->trier_ptr && !list_empty(&holder->donator))
-  {
-      list_remove(lock->trier_ptr);
-      lock->trier_ptr = NULL;
-      if(list_empty(&holder->donator))
-      {
-        holder->priority = holder->priority_before;
-        holder->priority_before = -1;
-      }
-      else
-      {
-        holder->priority = list_entry(list_max(&holder->donator, comp_priority, NULL), struct thread, donate_elem)->priority;
-      }
-  }
+  if (lock->stats != NULL)
+    lock_stats_released (lock->stats, timer_nanos () - lock->acquired);
   lock->holder = NULL;
+  sema_clear_owner (&lock->semaphore);
   sema_up (&lock->semaphore);
 }
 
+/* Records an acquisition in LS, which waited WAIT nanoseconds
+   if CONTENDED.  Locks that share a name share LS, and
+   lock_try_acquire() may run in an interrupt handler, so LS is
+   updated with interrupts off. */
+static void
+lock_stats_acquired (struct lock_stats *ls, int64_t wait, bool contended)
+{
+  enum intr_level old_level = intr_disable ();
+
+  ls->acquires++;
+  if (contended)
+    {
+      ls->contended++;
+      ls->wait_total_ns += wait;
+      if (wait > ls->wait_max_ns)
+        ls->wait_max_ns = wait;
+    }
+  intr_set_level (old_level);
+}
+
+/* Records in LS a release after holding a lock HOLD
+   nanoseconds. */
+static void
+lock_stats_released (struct lock_stats *ls, int64_t hold)
+{
+  enum intr_level old_level = intr_disable ();
+
+  ls->hold_total_ns += hold;
+  if (hold > ls->hold_max_ns)
+    ls->hold_max_ns = hold;
+  intr_set_level (old_level);
+}
+
 /* Returns true if the current thread holds LOCK, false
    otherwise.  (Note that testing whether some other thread holds
    a lock would be racy.) */
@@ -425,3 +605,265 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes readers-writer lock RW.
+
+   Any number of readers may hold RW at once, or a single writer.
+   Writers are preferred: a writer holds RW's lock from the time
+   it arrives, so readers that come after it wait in
+   lock_acquire(), donating their priority to it, while the
+   readers already inside drain out.  The writer donates its
+   priority to those readers in turn, but only to the first
+   RWLOCK_DONEES of them; any others drain out at their own
+   priority. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  int i;
+
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->lock);
+  rw->readers = 0;
+  rw->writer_waiting = false;
+  sema_init (&rw->drained, 0);
+  for (i = 0; i < RWLOCK_DONEES; i++)
+    sema_init (&rw->donees[i], 0);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds or is
+   waiting for it. */
+void
+rwlock_read_acquire (struct rwlock *rw)
+{
+  enum intr_level old_level;
+  int i;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+
+  lock_acquire (&rw->lock);
+  old_level = intr_disable ();
+  rw->readers++;
+  for (i = 0; i < RWLOCK_DONEES; i++)
+    if (rw->donees[i].owner == NULL)
+      {
+        sema_set_owner (&rw->donees[i], thread_current ());
+        break;
+      }
+  intr_set_level (old_level);
+  lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void
+rwlock_read_release (struct rwlock *rw)
+{
+  enum intr_level old_level;
+  int i;
+
+  ASSERT (rw != NULL);
+
+  old_level = intr_disable ();
+  ASSERT (rw->readers > 0);
+  for (i = 0; i < RWLOCK_DONEES; i++)
+    if (rw->donees[i].owner == thread_current ())
+      {
+        rw->donees[i].donation = -1;
+        sema_clear_owner (&rw->donees[i]);
+        break;
+      }
+  if (--rw->readers == 0 && rw->writer_waiting)
+    {
+      rw->writer_waiting = false;
+      sema_up (&rw->drained);
+    }
+  intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it. */
+void
+rwlock_write_acquire (struct rwlock *rw)
+{
+  enum intr_level old_level;
+  int i;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+
+  lock_acquire (&rw->lock);
+  old_level = intr_disable ();
+  while (rw->readers > 0)
+    {
+      rw->writer_waiting = true;
+      if (!thread_mlfqs)
+        for (i = 0; i < RWLOCK_DONEES; i++)
+          if (rw->donees[i].owner != NULL)
+            donate (&rw->donees[i], thread_current ()->priority);
+      sema_down (&rw->drained);
+    }
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void
+rwlock_write_release (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+  ASSERT (lock_held_by_current_thread (&rw->lock));
+
+  lock_release (&rw->lock);
+}
+
+/* Initializes sequence lock SL. */
+void
+seqlock_init (struct seqlock *sl)
+{
+  ASSERT (sl != NULL);
+
+  sl->seq = 0;
+}
+
+/* Starts a read of the data protected by SL and returns the value
+   to pass to seqlock_read_retry() afterward. */
+unsigned
+seqlock_read_begin (const struct seqlock *sl)
+{
+  unsigned seq;
+
+  while ((seq = sl->seq) & 1)
+    asm volatile ("pause");
+  barrier ();
+  return seq;
+}
+
+/* Returns true if a write to SL overlapped the read that began
+   when seqlock_read_begin() returned SEQ, in which case the read
+   must be repeated. */
+bool
+seqlock_read_retry (const struct seqlock *sl, unsigned seq)
+{
+  barrier ();
+  return sl->seq != seq;
+}
+
+/* Starts a write to the data protected by SL.  Writers must
+   exclude each other by other means. */
+void
+seqlock_write_begin (struct seqlock *sl)
+{
+  sl->seq++;
+  barrier ();
+}
+
+/* Finishes a write to the data protected by SL. */
+void
+seqlock_write_end (struct seqlock *sl)
+{
+  barrier ();
+  sl->seq++;
+}
+
+/* Initializes spin lock L, named NAME for debugging. */
+void
+spinlock_init (struct spinlock *l, const char *name)
+{
+  ASSERT (l != NULL);
+
+  l->locked = 0;
+  l->holder = NULL;
+  l->name = name;
+}
+
+/* Atomically stores NEW in *P and returns the old value. */
+static inline uint32_t
+atomic_xchg (volatile uint32_t *p, uint32_t new)
+{
+  /* See [IA32-v2b] "XCHG".  XCHG with a memory operand is always
+     locked. */
+  asm volatile ("xchgl %0, %1" : "+r" (new), "+m" (*p) : : "memory");
+  return new;
+}
+
+/* Acquires spin lock L, disabling interrupts on this CPU and
+   busy-waiting until no other CPU holds it.  L must not already
+   be held by the running thread. */
+void
+spinlock_acquire (struct spinlock *l)
+{
+  enum intr_level old_level = intr_disable ();
+
+  ASSERT (!spinlock_held (l));
+  while (atomic_xchg (&l->locked, 1) != 0)
+    while (l->locked)
+      asm volatile ("pause");
+  l->holder = thread_current ();
+  l->old_level = old_level;
+}
+
+/* Releases spin lock L, which the running thread must hold, and
+   restores the interrupt level from before it was acquired. */
+void
+spinlock_release (struct spinlock *l)
+{
+  enum intr_level old_level = l->old_level;
+
+  ASSERT (spinlock_held (l));
+  l->holder = NULL;
+  atomic_xchg (&l->locked, 0);
+  intr_set_level (old_level);
+}
+
+/* Returns true if the running thread holds spin lock L. */
+bool
+spinlock_held (const struct spinlock *l)
+{
+  return l->locked && l->holder == thread_current ();
+}
+
+/* Prints priority inversion statistics. */
+void
+synch_print_stats (void)
+{
+  if (inversion_cnt == 0)
+    return;
+  printf ("Synch: %lld priority inversions, %lld us total, %lld us worst\n",
+          inversion_cnt, inversion_total_ns / 1000, inversion_max_ns / 1000);
+}
+
+/* Prints lock contention statistics, locks with the most total
+   wait time first. */
+void
+lock_print_stats (void)
+{
+  struct lock_stats *sorted[LOCK_STATS_MAX];
+  int cnt, i, j;
+
+  if (!lock_profiling)
+    return;
+
+  cnt = lock_stats_cnt;
+  for (i = 0; i < cnt; i++)
+    {
+      struct lock_stats *ls = &lock_stats[i];
+      for (j = i; j > 0 && sorted[j - 1]->wait_total_ns < ls->wait_total_ns; j--)
+        sorted[j] = sorted[j - 1];
+      sorted[j] = ls;
+    }
+
+  printf ("Locks: %-24s %10s %9s %10s %10s %10s %10s\n", "name", "acquires",
+          "contended", "wait us", "max wait", "hold us", "max hold");
+  for (i = 0; i < cnt; i++)
+    {
+      const struct lock_stats *ls = sorted[i];
+      if (ls->acquires == 0)
+        continue;
+      printf ("Locks: %-24s %10lld %9lld %10lld %10lld %10lld %10lld\n",
+              ls->name, ls->acquires, ls->contended,
+              ls->wait_total_ns / 1000, ls->wait_max_ns / 1000,
+              ls->hold_total_ns / 1000, ls->hold_max_ns / 1000);
+    }
+  if (lock_stats_dropped > 0)
+    printf ("Locks: %lld locks not tracked (table full)\n", lock_stats_dropped);
+}
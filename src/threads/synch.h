@@ -3,29 +3,51 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
 
 /* A counting semaphore. */
 struct semaphore 
   {
     unsigned value;             /* Current value. */
     struct list waiters;        /* List of waiting threads. */
+
+    /* Priority donation.  If the thread that will up the
+       semaphore is known, it is the owner, and waiters donate
+       their priority to it. */
+    struct thread *owner;       /* Owner, or null. */
+    struct list_elem owner_elem; /* Element in owner's `held' list. */
+    int donation;               /* Highest waiter priority, or -1. */
   };
 
 void sema_init (struct semaphore *, unsigned value);
 void sema_down (struct semaphore *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
+void sema_set_owner (struct semaphore *, struct thread *);
+void sema_clear_owner (struct semaphore *);
 void sema_self_test (void);
+void synch_print_stats (void);
+void lock_print_stats (void);
 
 /* Lock. */
 struct lock 
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
-    struct list_elem *trier_ptr;
+    struct lock_stats *stats;   /* Contention statistics, or null. */
+    int64_t acquired;           /* timer_nanos() when acquired. */
   };
 
-void lock_init (struct lock *);
+/* Names each lock after the expression used to initialize it, so
+   that the contention profiler can report it. */
+#define lock_init(LOCK) lock_init_named (LOCK, #LOCK)
+
+/* If true, lock_acquire() and lock_release() keep contention
+   statistics.  Set by kernel command-line option "-lockprof". */
+extern bool lock_profiling;
+
+void lock_init_named (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
@@ -42,6 +64,73 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Readers-writer lock. */
+#define RWLOCK_DONEES 8         /* Readers that can receive donations. */
+
+struct rwlock
+  {
+    struct lock lock;           /* Held by the writer, if any. */
+    unsigned readers;           /* # of threads with read access. */
+    bool writer_waiting;        /* Writer waiting for readers to leave? */
+    struct semaphore drained;   /* Upped when the last reader leaves. */
+
+    /* Priority donation to readers.  Each of the first
+       RWLOCK_DONEES readers inside owns one of these semaphores,
+       through which a waiting writer donates its priority. */
+    struct semaphore donees[RWLOCK_DONEES];
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_read_acquire (struct rwlock *);
+void rwlock_read_release (struct rwlock *);
+void rwlock_write_acquire (struct rwlock *);
+void rwlock_write_release (struct rwlock *);
+
+/* Sequence lock.
+
+   For small, frequently read values that are written by one
+   writer at a time, such as from an interrupt handler.  Readers
+   never block the writer; they retry if a write overlapped their
+   read:
+
+        unsigned seq;
+        do
+          {
+            seq = seqlock_read_begin (&sl);
+            ...copy the protected data...
+          }
+        while (seqlock_read_retry (&sl, seq));
+*/
+struct seqlock
+  {
+    volatile unsigned seq;      /* Odd while a write is in progress. */
+  };
+
+void seqlock_init (struct seqlock *);
+unsigned seqlock_read_begin (const struct seqlock *);
+bool seqlock_read_retry (const struct seqlock *, unsigned seq);
+void seqlock_write_begin (struct seqlock *);
+void seqlock_write_end (struct seqlock *);
+
+/* Spin lock.
+
+   Excludes other CPUs as well as interrupt handlers on this one,
+   so it may be used in interrupt context and below the thread
+   scheduler.  The holder must not sleep and should keep the
+   critical section short. */
+struct spinlock
+  {
+    volatile uint32_t locked;   /* Nonzero while held. */
+    struct thread *holder;      /* Holding thread (for debugging). */
+    enum intr_level old_level;  /* Interrupt level before acquire. */
+    const char *name;           /* Name (for debugging). */
+  };
+
+void spinlock_init (struct spinlock *, const char *name);
+void spinlock_acquire (struct spinlock *);
+void spinlock_release (struct spinlock *);
+bool spinlock_held (const struct spinlock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
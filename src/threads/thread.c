@@ -11,6 +11,7 @@
 #include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -26,12 +27,15 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
-
-/* list of blocked process */
-struct list blocked_list;
+/* Processes in THREAD_READY state, that is, processes that are
+   ready to run but not actually running.  There is one FIFO
+   queue per priority, and bit P of ready_bits is set exactly
+   when ready_queues[P] is nonempty, so both enqueueing and
+   picking the highest-priority thread take constant time. */
+#define READY_WORD_BITS 32
+static struct list ready_queues[PRI_MAX + 1];
+static uint32_t ready_bits[(PRI_MAX + READY_WORD_BITS) / READY_WORD_BITS];
+static int ready_count;         /* # of threads in ready_queues. */
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -64,6 +68,17 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* System load average, for the multi-level feedback queue
+   scheduler. */
+static fixed_t load_avg;
+
+/* Threads whose recent_cpu or nice is nonzero.  Every other
+   thread has recent_cpu 0, which the once-per-second decay
+   leaves unchanged, so only these need recomputing then.  A
+   thread joins when it is charged a tick or made non-nice and
+   leaves once its recent_cpu has decayed back to 0. */
+static struct list mlfqs_active_list;
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -75,6 +90,12 @@ static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static void ready_enqueue (struct thread *);
+static void ready_remove (struct thread *);
+static int ready_max_priority (void);
+static void mlfqs_tick (struct thread *);
+static int mlfqs_priority (const struct thread *);
+static void mlfqs_activate (struct thread *);
 #ifdef USERPROG
 struct thread *
 get_thread_by_tid(tid_t tid)
@@ -115,12 +136,14 @@ get_thread_by_tid(tid_t tid)
 void
 thread_init (void) 
 {
+  int i;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
-  list_init (&ready_list);
-
-  list_init(&blocked_list);
+  for (i = 0; i <= PRI_MAX; i++)
+    list_init (&ready_queues[i]);
+  list_init (&mlfqs_active_list);
 #ifdef USERPROG
     lock_init(&process_execute_lock);
 #endif
@@ -166,6 +189,9 @@ thread_tick (void)
   else
     kernel_ticks++;
 
+  if (thread_mlfqs)
+    mlfqs_tick (t);
+
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE)
     intr_yield_on_return ();
@@ -221,8 +247,11 @@ thread_create (const char *name, int priority,
   t->dying_fin = false;
   t->load_fail = false;
   list_init(&t->fd_list);
+  t->ioring = NULL;
   sema_init(&t->wait_sema, 0);
   sema_init(&t->fin_sema, 0);
+  /* A parent in process_wait() donates to us. */
+  sema_set_owner(&t->wait_sema, t);
 #endif
 #ifdef VM
   hash_init(&t->SPT, page_hash_func, page_less_func, NULL);
@@ -291,7 +320,7 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
-  list_push_back (&ready_list, &t->elem);
+  ready_enqueue (t);
   t->status = THREAD_READY;
   intr_set_level (old_level);
 }
@@ -342,6 +371,11 @@ thread_exit (void)
   /* Just set our status to dying and schedule another process.
      We will be destroyed during the call to schedule_tail(). */
   intr_disable ();
+  while (!list_empty (&thread_current ()->held))
+    sema_clear_owner (list_entry (list_front (&thread_current ()->held),
+                                  struct semaphore, owner_elem));
+  if (thread_current ()->mlfqs_active)
+    list_remove (&thread_current ()->mlfqs_elem);
   thread_current ()->status = THREAD_DYING;
   schedule ();
   NOT_REACHED ();
@@ -359,7 +393,7 @@ thread_yield (void)
 
   old_level = intr_disable ();
   if (curr != idle_thread) 
-    list_push_back (&ready_list, &curr->elem);
+    ready_enqueue (curr);
   curr->status = THREAD_READY;
   schedule ();
   intr_set_level (old_level);
@@ -370,15 +404,62 @@ void
 thread_set_priority (int new_priority) 
 {
   struct thread *t = thread_current();
-  if(t->priority_before == -1)
-    t->priority = new_priority;
-  else
-  {
-      /* if lock aquired */
-      t->priority_before = new_priority;
-  }
+  if(thread_mlfqs)
+    return;
+  t->base_priority = new_priority;
+  thread_refresh_priority(t);
   thread_yield();
-  
+}
+
+/* Recomputes the effective priority of T as the larger of its own
+   priority and the donations waiting on the semaphores it owns.
+   Each semaphore caches its highest waiter priority, so this
+   costs time in the number of semaphores T owns, not in the
+   number of its donors. */
+void
+thread_refresh_priority (struct thread *t)
+{
+  enum intr_level old_level;
+  struct list_elem *e;
+  int priority;
+
+  if (thread_mlfqs)
+    return;
+
+  old_level = intr_disable ();
+  priority = t->base_priority;
+  for (e = list_begin (&t->held); e != list_end (&t->held); e = list_next (e))
+    {
+      struct semaphore *s = list_entry (e, struct semaphore, owner_elem);
+      if (s->donation > priority)
+        priority = s->donation;
+    }
+  thread_update_priority (t, priority);
+  intr_set_level (old_level);
+}
+
+/* Changes the effective priority of T to PRIORITY, moving T to
+   the matching run queue if it is currently ready to run.  Used
+   by priority donation in synch.c, which may raise the priority
+   of a thread that has been preempted while holding a lock. */
+void
+thread_update_priority (struct thread *t, int priority)
+{
+  enum intr_level old_level;
+
+  ASSERT (is_thread (t));
+  ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+  old_level = intr_disable ();
+  if (t->status == THREAD_READY && t->priority != priority)
+    {
+      ready_remove (t);
+      t->priority = priority;
+      ready_enqueue (t);
+    }
+  else
+    t->priority = priority;
+  intr_set_level (old_level);
 }
 
 /* Returns the current thread's priority. */
@@ -388,35 +469,132 @@ thread_get_priority (void)
   return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Sets the current thread's nice value to NICE and recalculates
+   its priority, yielding if it no longer has the highest
+   priority. */
 void
-thread_set_nice (int nice UNUSED) 
+thread_set_nice (int nice) 
 {
-  /* Not yet implemented. */
+  struct thread *t = thread_current ();
+  enum intr_level old_level;
+  bool preempt;
+
+  ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+  old_level = intr_disable ();
+  t->nice = nice;
+  if (nice != 0)
+    mlfqs_activate (t);
+  if (thread_mlfqs)
+    t->priority = mlfqs_priority (t);
+  preempt = ready_max_priority () > t->priority;
+  intr_set_level (old_level);
+
+  if (preempt)
+    thread_yield ();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int load = FP_TO_INT_NEAREST (FP_MUL_INT (load_avg, 100));
+  intr_set_level (old_level);
+  return load;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int cpu = FP_TO_INT_NEAREST (FP_MUL_INT (thread_current ()->recent_cpu, 100));
+  intr_set_level (old_level);
+  return cpu;
+}
+
+/* Returns the 4.4BSD scheduler priority of T. */
+static int
+mlfqs_priority (const struct thread *t)
+{
+  int priority = PRI_MAX - FP_TO_INT_ZERO (FP_DIV_INT (t->recent_cpu, 4))
+                 - t->nice * 2;
+
+  if (priority < PRI_MIN)
+    return PRI_MIN;
+  if (priority > PRI_MAX)
+    return PRI_MAX;
+  return priority;
+}
+
+/* Puts T on mlfqs_active_list if it is not already there. */
+static void
+mlfqs_activate (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!t->mlfqs_active && t != idle_thread)
+    {
+      list_push_back (&mlfqs_active_list, &t->mlfqs_elem);
+      t->mlfqs_active = true;
+    }
+}
+
+/* Multi-level feedback queue bookkeeping for a timer tick while
+   T is running.  Only T's recent_cpu changes from tick to tick,
+   so only T's priority is recalculated every fourth tick; the
+   once-per-second decay walks just mlfqs_active_list. */
+static void
+mlfqs_tick (struct thread *t)
+{
+  int64_t ticks = timer_ticks ();
+
+  if (t != idle_thread)
+    {
+      t->recent_cpu = FP_ADD_INT (t->recent_cpu, 1);
+      mlfqs_activate (t);
+    }
+
+  if (ticks % TIMER_FREQ == 0)
+    {
+      int ready = ready_count + (t != idle_thread ? 1 : 0);
+      fixed_t coef;
+      struct list_elem *e;
+
+      load_avg = FP_ADD (FP_DIV_INT (FP_MUL_INT (load_avg, 59), 60),
+                         FP_DIV_INT (FP_FROM_INT (ready), 60));
+      coef = FP_DIV (FP_MUL_INT (load_avg, 2),
+                     FP_ADD_INT (FP_MUL_INT (load_avg, 2), 1));
+
+      for (e = list_begin (&mlfqs_active_list);
+           e != list_end (&mlfqs_active_list); )
+        {
+          struct thread *a = list_entry (e, struct thread, mlfqs_elem);
+
+          a->recent_cpu = FP_ADD_INT (FP_MUL (coef, a->recent_cpu), a->nice);
+          thread_update_priority (a, mlfqs_priority (a));
+          if (a->recent_cpu == 0 && a->nice == 0)
+            {
+              a->mlfqs_active = false;
+              e = list_remove (e);
+            }
+          else
+            e = list_next (e);
+        }
+    }
+  else if (ticks % TIME_SLICE == 0 && t != idle_thread)
+    t->priority = mlfqs_priority (t);
+
+  if (ready_max_priority () > t->priority)
+    intr_yield_on_return ();
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -453,6 +631,7 @@ idle (void *idle_started_ UNUSED)
 
          See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
          7.11.1 "HLT Instruction". */
+      timer_idle_enter ();
       asm volatile ("sti; hlt" : : : "memory");
     }
 }
@@ -502,16 +681,28 @@ init_thread (struct thread *t, const char *name, int priority)
   t->status = THREAD_BLOCKED;
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
-  t->priority = priority;
-  t->priority_before = -1;
+  t->priority = t->base_priority = priority;
+  if (thread_mlfqs)
+    {
+      /* Inherit niceness and recent_cpu from the creator. */
+      struct thread *parent = running_thread ();
+      if (is_thread (parent) && parent != t)
+        {
+          t->nice = parent->nice;
+          t->recent_cpu = parent->recent_cpu;
+          if (t->nice != 0 || t->recent_cpu != 0)
+            mlfqs_activate (t);
+        }
+      t->priority = mlfqs_priority (t);
+    }
   t->magic = THREAD_MAGIC;
-  t->donatee = NULL;
-  list_init(&t->donator);
+  list_init (&t->held);
 #ifdef USERPROG
   list_init(&t->childs);
 #endif
 #ifdef VM
   list_init(&t->mmap_list);
+  list_init(&t->shm_list);
 #endif
 }
 
@@ -527,14 +718,49 @@ alloc_frame (struct thread *t, size_t size)
   t->stack -= size;
   return t->stack;
 }
-static bool
-comp_priority(const struct list_elem *A, const struct list_elem *B, void *aux)
+
+/* Adds T to the tail of the run queue for its priority. */
+static void
+ready_enqueue (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  list_push_back (&ready_queues[t->priority], &t->elem);
+  ready_count++;
+  ready_bits[t->priority / READY_WORD_BITS]
+    |= 1u << (t->priority % READY_WORD_BITS);
+}
+
+/* Removes ready thread T from its run queue. */
+static void
+ready_remove (struct thread *t)
 {
-    const struct thread *threadA = list_entry(A, struct thread, elem);
-    const struct thread *threadB = list_entry(B, struct thread, elem);
-    ASSERT(aux == NULL);
+  ASSERT (intr_get_level () == INTR_OFF);
 
-    return (threadA->priority < threadB->priority)? true:false;
+  list_remove (&t->elem);
+  ready_count--;
+  if (list_empty (&ready_queues[t->priority]))
+    ready_bits[t->priority / READY_WORD_BITS]
+      &= ~(1u << (t->priority % READY_WORD_BITS));
+}
+
+/* Returns the highest priority that has a ready thread, or -1 if
+   every run queue is empty. */
+static int
+ready_max_priority (void)
+{
+  int i;
+
+  for (i = sizeof ready_bits / sizeof *ready_bits - 1; i >= 0; i--)
+    if (ready_bits[i] != 0)
+      {
+        uint32_t bit;
+
+        /* Find last set bit.  See [IA32-v2a] "BSR". */
+        asm ("bsrl %1, %0" : "=r" (bit) : "rm" (ready_bits[i]) : "cc");
+        return i * READY_WORD_BITS + bit;
+      }
+  return -1;
 }
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
@@ -545,14 +771,13 @@ static struct thread *
 next_thread_to_run (void) 
 {
   struct thread *t;
-  struct list_elem *e;
-  if (list_empty (&ready_list))
+  int priority = ready_max_priority ();
+  if (priority < 0)
     return idle_thread;
   else
   {
-      e = list_max(&ready_list, comp_priority, NULL);
-      t = list_entry(e, struct thread, elem);
-      list_remove(e);
+      t = list_entry (list_front (&ready_queues[priority]), struct thread, elem);
+      ready_remove (t);
       return t;
   }
 }
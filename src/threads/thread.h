@@ -6,6 +6,7 @@
 #include <hash.h>
 #include <stdint.h>
 #include "threads/synch.h"
+#include "threads/fixed-point.h"
 #ifdef EFILESYS
 #include "filesys/directory.h"
 #endif
@@ -29,6 +30,11 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness. */
+#define NICE_MIN -20                    /* Nicest to other threads. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice. */
+
 /* A kernel thread or user process.
 
    Each thread structure is stored in its own 4 kB page.  The
@@ -92,6 +98,9 @@ struct fd_wrap
     struct dir *dir;
 #endif
     int fd;
+    int flags;                  /* O_* flags given to open_flags(). */
+    struct pipe *pipe;          /* Pipe, if FILE is null. */
+    bool writer;                /* Write end of PIPE? */
     struct list_elem elem;
 };
 
@@ -102,17 +111,20 @@ struct thread
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    int priority;                       /* Priority. */
-    int priority_before;                /* Priority before donate */
+    int priority;                       /* Effective priority. */
+    int base_priority;                  /* Priority without donations. */
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
-    struct list_elem donate_elem;
-    struct list donator;
+    struct list held;                   /* Semaphores we own. */
+    struct semaphore *blocked_on;       /* Semaphore we are waiting on. */
+    int64_t inversion_start;            /* When an inversion began, or 0. */
 
-    struct thread *donatee;
-    /* timer_sleep */
-    int64_t ticks;
+    /* 4.4BSD scheduler. */
+    int nice;                           /* Niceness. */
+    fixed_t recent_cpu;                 /* Recent CPU time received. */
+    bool mlfqs_active;                  /* On mlfqs_active_list? */
+    struct list_elem mlfqs_elem;        /* mlfqs_active_list element. */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
@@ -126,16 +138,17 @@ struct thread
     struct semaphore fin_sema;
     struct file *executable;
     struct list_elem child_elem;
+    struct ioring *ioring;              /* Asynchronous I/O ring, if any. */
 #endif
 #ifdef VM
     struct hash SPT;
     struct list mmap_list;
+    struct list shm_list;               /* Shared memory references. */
 #endif
 #ifdef EFILESYS
     struct dir *CWD;
 #endif
-    void *syscall_esp;
-    bool is_syscall;
+    void *syscall_esp;                  /* User esp at syscall entry. */
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
   };
@@ -145,8 +158,6 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
-struct list blocked_list;
-
 void thread_init (void);
 void thread_start (void);
 
@@ -168,6 +179,8 @@ void thread_yield (void);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
+void thread_update_priority (struct thread *, int);
+void thread_refresh_priority (struct thread *);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
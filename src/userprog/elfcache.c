@@ -0,0 +1,125 @@
+#include "userprog/elfcache.h"
+#include <debug.h>
+#include <list.h>
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+
+/* Cache of parsed executables.
+
+   Programs are run over and over, and every exec used to read
+   and validate the same ELF and program headers again.  This
+   cache remembers the layout load() worked out for the last
+   ELF_CACHE_SIZE executables, most recently used first.
+
+   An entry keeps its executable's inode open, which keeps the
+   inode's write count alive.  An entry whose inode has been
+   written since the layout was read is dropped when it is next
+   looked up.  An entry whose inode has been removed would keep
+   the file's sectors allocated, so every lookup and insertion
+   first drops all such entries.
+
+   Every caller holds filesys_lock, which protects the cache. */
+
+/* Executables remembered. */
+#define ELF_CACHE_SIZE 8
+
+struct elf_cache_entry
+  {
+    struct inode *inode;        /* Executable, held open. */
+    unsigned write_cnt;         /* INODE's write count when read. */
+    struct elf_layout layout;
+    struct list_elem elem;      /* Element in elf_cache. */
+  };
+
+static struct list elf_cache;
+static size_t elf_cache_cnt;
+
+/* Initializes the executable cache. */
+void
+elf_cache_init (void)
+{
+  list_init (&elf_cache);
+  elf_cache_cnt = 0;
+}
+
+/* Removes entry E from the cache and frees it. */
+static void
+elf_cache_drop (struct elf_cache_entry *e)
+{
+  list_remove (&e->elem);
+  elf_cache_cnt--;
+  inode_close (e->inode);
+  free (e);
+}
+
+/* Drops every entry whose inode has been removed, releasing
+   the inode so its sectors can be freed. */
+static void
+elf_cache_prune (void)
+{
+  struct list_elem *el = list_begin (&elf_cache);
+
+  while (el != list_end (&elf_cache))
+    {
+      struct elf_cache_entry *e = list_entry (el, struct elf_cache_entry,
+                                              elem);
+      el = list_next (el);
+      if (inode_is_removed (e->inode))
+        elf_cache_drop (e);
+    }
+}
+
+/* Looks up executable INODE.  If its layout is cached and still
+   current, copies it into *LAYOUT and returns true. */
+bool
+elf_cache_lookup (struct inode *inode, struct elf_layout *layout)
+{
+  struct list_elem *el;
+
+  elf_cache_prune ();
+  for (el = list_begin (&elf_cache); el != list_end (&elf_cache);
+       el = list_next (el))
+    {
+      struct elf_cache_entry *e = list_entry (el, struct elf_cache_entry,
+                                              elem);
+      if (e->inode != inode)
+        continue;
+      if (e->write_cnt != inode_get_write_cnt (inode))
+        {
+          elf_cache_drop (e);
+          return false;
+        }
+      list_remove (&e->elem);
+      list_push_front (&elf_cache, &e->elem);
+      *layout = e->layout;
+      return true;
+    }
+  return false;
+}
+
+/* Remembers LAYOUT, just read from executable INODE, evicting
+   the least recently used entry if the cache is full.  Does
+   nothing if memory is short. */
+void
+elf_cache_insert (struct inode *inode, const struct elf_layout *layout)
+{
+  struct elf_cache_entry *e;
+
+  elf_cache_prune ();
+
+  /* Removed executables only take up disk space while cached. */
+  if (inode_is_removed (inode))
+    return;
+
+  e = malloc (sizeof *e);
+  if (e == NULL)
+    return;
+  e->inode = inode_reopen (inode);
+  e->write_cnt = inode_get_write_cnt (inode);
+  e->layout = *layout;
+  list_push_front (&elf_cache, &e->elem);
+
+  if (++elf_cache_cnt > ELF_CACHE_SIZE)
+    elf_cache_drop (list_entry (list_back (&elf_cache),
+                                struct elf_cache_entry, elem));
+}
@@ -0,0 +1,36 @@
+#ifndef USERPROG_ELFCACHE_H
+#define USERPROG_ELFCACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct inode;
+
+/* Most loadable segments in an executable. */
+#define ELF_SEGS_MAX 8
+
+/* A loadable segment, already validated and rounded out to whole
+   pages, in the form load_segment() takes. */
+struct elf_segment
+  {
+    uint32_t file_page;         /* Page-aligned file offset. */
+    uint32_t mem_page;          /* Page-aligned user address. */
+    uint32_t read_bytes;        /* Bytes to read from the file. */
+    uint32_t zero_bytes;        /* Bytes to zero after them. */
+    bool writable;
+  };
+
+/* What load() needs to know about an executable. */
+struct elf_layout
+  {
+    uint32_t entry;             /* Entry point. */
+    size_t seg_cnt;             /* Number of segments. */
+    struct elf_segment segs[ELF_SEGS_MAX];
+  };
+
+void elf_cache_init (void);
+bool elf_cache_lookup (struct inode *, struct elf_layout *);
+void elf_cache_insert (struct inode *, const struct elf_layout *);
+
+#endif /* userprog/elfcache.h */
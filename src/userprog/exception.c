@@ -2,10 +2,12 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/uaccess.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #ifdef VM
 #include "vm/page.h"
+#include "vm/cow.h"
 #include <hash.h>
 #include "threads/palloc.h"
 #include "filesys/file.h"
@@ -174,12 +176,19 @@ page_fault (struct intr_frame *f)
           {
               return;
           }
+          else if(write && elem->type == VM_COW)
+          {
+            lock_acquire(&page_lock);
+            success = cow_fault(elem);
+            lock_release(&page_lock);
+            break;
+          }
       }
   }
 
   if(success) return;
   // stack growth
-  void *esp = (f->esp < PHYS_BASE || t->is_syscall == false) ? f->esp : t->syscall_esp;
+  void *esp = user ? f->esp : t->syscall_esp;
   if((esp - 32) <= fault_addr && fault_addr > 0xbf000000)
   {
       if(!palloc_user_page((void *)((uint32_t)fault_addr & 0xfffff000), VM_STACK,  NULL)) thread_exit();
@@ -187,6 +196,18 @@ page_fault (struct intr_frame *f)
   }
 #endif
 true_fault:
+  /* A fault in one of the user memory accessors in uaccess.c
+     makes that accessor report failure. */
+  if (!user)
+    {
+      uintptr_t fixup = search_exception_table ((uintptr_t) f->eip);
+      if (fixup != 0)
+        {
+          f->eip = (void (*) (void)) fixup;
+          return;
+        }
+    }
+
   /* Count page faults. */
   page_fault_cnt++;
 
@@ -0,0 +1,425 @@
+#include "userprog/ioring.h"
+#include <debug.h>
+#include <ioring.h>
+#include <list.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/syscall.h"
+#include "userprog/uaccess.h"
+#ifdef EFILESYS
+#include "filesys/directory.h"
+#endif
+#ifdef VM
+#include "vm/page.h"
+#endif
+
+/* Asynchronous I/O rings.
+
+   A ring's pages are allocated from the user pool and mapped
+   into the owning process, but they have no supplemental page
+   table entries, so they are never evicted and the kernel reads
+   and writes them through their kernel addresses.  That is what
+   lets the worker threads below, which run outside the process's
+   address space, fill in completions and move data to and from
+   the buffer area.
+
+   io_enter() takes submissions off the queue in the calling
+   process, resolving each descriptor to a private reopened file
+   so that closing the descriptor does not disturb requests in
+   flight.  A pool of IORING_WORKERS kernel threads executes the
+   requests and posts their completions.  The workers take
+   filesys_lock like every other file system user, so requests
+   run one at a time against the file system; what the process
+   gains is not waiting for them, and paying one trap per batch
+   rather than per operation. */
+
+/* Number of worker threads. */
+#define IORING_WORKERS 2
+
+/* A process's ring. */
+struct ioring
+  {
+    struct io_ring_hdr *hdr;    /* Kernel address of header page. */
+    uint8_t *bufs;              /* Kernel address of buffer area. */
+    void *uaddr;                /* User address of header page. */
+    size_t page_cnt;            /* Pages mapped at UADDR. */
+    uint32_t buf_size;          /* Bytes in the buffer area. */
+    uint32_t sq_head;           /* Next submission to take. */
+
+    struct lock lock;           /* Protects the members below. */
+    uint32_t cq_tail;           /* Next completion slot. */
+    size_t inflight;            /* Requests queued or executing. */
+    struct condition done;      /* Signaled on each completion. */
+  };
+
+/* A request handed to the workers. */
+struct io_request
+  {
+    struct ioring *ring;        /* Ring to complete on. */
+    struct io_sqe sqe;          /* Copy of the submission. */
+    struct file *file;          /* Private reopened file. */
+    struct list_elem elem;      /* Element in work_queue. */
+  };
+
+/* The header and both queues must fit in the header page. */
+typedef char hdr_fits[sizeof (struct io_ring_hdr) <= IORING_PAGES * PGSIZE
+                      ? 1 : -1];
+
+static struct slab_cache request_cache;
+static struct list work_queue;          /* Pending requests. */
+static struct lock work_lock;           /* Protects work_queue. */
+static struct condition work_ready;     /* Signaled when queued. */
+static bool workers_started;
+
+static void worker (void *);
+static void post_completion (struct ioring *, uint32_t user_data,
+                             int32_t res);
+
+/* Initializes the asynchronous I/O subsystem. */
+void
+ioring_init (void)
+{
+  slab_cache_init (&request_cache, "io_request",
+                   sizeof (struct io_request), 0);
+  list_init (&work_queue);
+  lock_init (&work_lock);
+  cond_init (&work_ready);
+}
+
+/* Returns true if user page UPAGE of the current process is in
+   use for anything. */
+static bool
+page_in_use (void *upage)
+{
+  struct thread *t = thread_current ();
+  if (pagedir_get_page (t->pagedir, upage) != NULL)
+    return true;
+#ifdef VM
+  if (vm_lookup_page (upage) != NULL)
+    return true;
+#endif
+  return false;
+}
+
+/* Starts the worker pool the first time a ring is set up. */
+static void
+start_workers (void)
+{
+  int i;
+
+  lock_acquire (&work_lock);
+  if (!workers_started)
+    {
+      for (i = 0; i < IORING_WORKERS; i++)
+        {
+          char name[16];
+          snprintf (name, sizeof name, "io_worker%d", i);
+          thread_create (name, PRI_DEFAULT, worker, NULL);
+        }
+      workers_started = true;
+    }
+  lock_release (&work_lock);
+}
+
+/* Creates a ring for the current process with BUF_PAGES pages of
+   buffer area and maps it at UADDR, which must be page-aligned
+   and have IORING_PAGES + BUF_PAGES unused pages after it.
+   Returns true if successful, false if the process already has a
+   ring, the arguments are bad or memory is short. */
+bool
+ioring_setup (void *uaddr, size_t buf_pages)
+{
+  struct thread *t = thread_current ();
+  struct ioring *ring;
+  size_t page_cnt = IORING_PAGES + buf_pages;
+  uint8_t *kpage;
+  size_t i;
+
+  if (t->ioring != NULL || buf_pages > IORING_BUF_PAGES_MAX
+      || uaddr == NULL || pg_ofs (uaddr) != 0
+      || !is_user_range (uaddr, page_cnt * PGSIZE))
+    return false;
+  for (i = 0; i < page_cnt; i++)
+    if (page_in_use ((uint8_t *) uaddr + i * PGSIZE))
+      return false;
+
+  ring = malloc (sizeof *ring);
+  kpage = palloc_get_multiple (PAL_USER | PAL_ZERO, page_cnt);
+  if (ring == NULL || kpage == NULL)
+    goto fail;
+  for (i = 0; i < page_cnt; i++)
+    if (!pagedir_set_page (t->pagedir, (uint8_t *) uaddr + i * PGSIZE,
+                           kpage + i * PGSIZE, true))
+      {
+        while (i-- > 0)
+          pagedir_clear_page (t->pagedir, (uint8_t *) uaddr + i * PGSIZE);
+        goto fail;
+      }
+
+  ring->hdr = (struct io_ring_hdr *) kpage;
+  ring->buf_size = buf_pages * PGSIZE;
+  ring->hdr->buf_size = ring->buf_size;
+  ring->bufs = kpage + IORING_PAGES * PGSIZE;
+  ring->uaddr = uaddr;
+  ring->page_cnt = page_cnt;
+  ring->sq_head = 0;
+  lock_init (&ring->lock);
+  ring->cq_tail = 0;
+  ring->inflight = 0;
+  cond_init (&ring->done);
+  t->ioring = ring;
+
+  start_workers ();
+  return true;
+
+ fail:
+  palloc_free_multiple (kpage, page_cnt);
+  free (ring);
+  return false;
+}
+
+/* Returns the number of further completions RING can accept
+   without overwriting ones the process has not consumed.
+   RING's lock must be held. */
+static size_t
+cq_room (struct ioring *ring)
+{
+  uint32_t pending = ring->cq_tail - ring->hdr->cq_head;
+
+  /* CQ_HEAD belongs to the process, so it may be anything. */
+  if (pending > IORING_CQ_ENTRIES)
+    pending = IORING_CQ_ENTRIES;
+  if (pending + ring->inflight >= IORING_CQ_ENTRIES)
+    return 0;
+  return IORING_CQ_ENTRIES - pending - ring->inflight;
+}
+
+/* Checks SQE and, for a read or write, opens its file.  Returns
+   the new request, or NULL if SQE is invalid.  SQE must be a
+   kernel copy: the process can rewrite anything in its ring
+   pages, so nothing else there may be trusted. */
+static struct io_request *
+prepare_request (struct ioring *ring, const struct io_sqe *sqe)
+{
+  struct io_request *r;
+  struct fd_wrap *fd_wrapper;
+  struct file *file;
+
+  if (sqe->opcode != IO_OP_FSYNC)
+    {
+      if ((sqe->opcode != IO_OP_READ && sqe->opcode != IO_OP_WRITE)
+          || sqe->offset < 0
+          || sqe->buf > ring->buf_size
+          || sqe->len > ring->buf_size - sqe->buf)
+        return NULL;
+    }
+
+  lock_acquire (&filesys_lock);
+  fd_wrapper = get_fd_wrapper_by_fd (sqe->fd);
+  file = fd_wrapper != NULL && fd_wrapper->file != NULL
+         ? file_reopen (fd_wrapper->file) : NULL;
+  lock_release (&filesys_lock);
+  if (file == NULL)
+    return NULL;
+#ifdef EFILESYS
+  if (is_inode_dir (file_get_inode (file)))
+    {
+      lock_acquire (&filesys_lock);
+      file_close (file);
+      lock_release (&filesys_lock);
+      return NULL;
+    }
+#endif
+
+  r = slab_alloc (&request_cache);
+  if (r == NULL)
+    {
+      lock_acquire (&filesys_lock);
+      file_close (file);
+      lock_release (&filesys_lock);
+      return NULL;
+    }
+  r->ring = ring;
+  r->sqe = *sqe;
+  r->file = file;
+  return r;
+}
+
+/* Submits up to TO_SUBMIT entries from the current process's
+   submission queue, then waits until at least MIN_COMPLETE
+   completions are waiting to be consumed or nothing is left in
+   flight.  Invalid submissions complete at once with result -1.
+   Submission stops early if the completion queue could
+   otherwise overflow.  Returns the number of entries taken from
+   the submission queue, or -1 if the process has no ring. */
+int
+ioring_enter (size_t to_submit, size_t min_complete)
+{
+  struct ioring *ring = thread_current ()->ioring;
+  struct io_ring_hdr *hdr;
+  uint32_t sq_tail;
+  size_t submitted = 0;
+
+  if (ring == NULL)
+    return -1;
+  hdr = ring->hdr;
+
+  sq_tail = hdr->sq_tail;
+  barrier ();
+  if (sq_tail - ring->sq_head > IORING_SQ_ENTRIES)
+    return -1;
+  if (to_submit > sq_tail - ring->sq_head)
+    to_submit = sq_tail - ring->sq_head;
+
+  while (submitted < to_submit)
+    {
+      struct io_sqe sqe;
+      struct io_request *r;
+      bool room;
+
+      lock_acquire (&ring->lock);
+      room = cq_room (ring) > 0;
+      if (room)
+        ring->inflight++;
+      lock_release (&ring->lock);
+      if (!room)
+        break;
+
+      sqe = hdr->sq[ring->sq_head % IORING_SQ_ENTRIES];
+      ring->sq_head++;
+      hdr->sq_head = ring->sq_head;
+      submitted++;
+
+      r = sqe.opcode != IO_OP_NOP ? prepare_request (ring, &sqe) : NULL;
+      if (r != NULL)
+        {
+          lock_acquire (&work_lock);
+          list_push_back (&work_queue, &r->elem);
+          cond_signal (&work_ready, &work_lock);
+          lock_release (&work_lock);
+        }
+      else
+        post_completion (ring, sqe.user_data,
+                         sqe.opcode == IO_OP_NOP ? 0 : -1);
+    }
+
+  lock_acquire (&ring->lock);
+  while (ring->inflight > 0
+         && ring->cq_tail - hdr->cq_head < min_complete)
+    cond_wait (&ring->done, &ring->lock);
+  lock_release (&ring->lock);
+
+  return submitted;
+}
+
+/* Waits for the current process's outstanding requests and
+   unmaps and frees its ring, if it has one.  Must be called
+   without filesys_lock held, because the workers need it. */
+void
+ioring_destroy (void)
+{
+  struct thread *t = thread_current ();
+  struct ioring *ring = t->ioring;
+  size_t i;
+
+  if (ring == NULL)
+    return;
+
+  lock_acquire (&ring->lock);
+  while (ring->inflight > 0)
+    cond_wait (&ring->done, &ring->lock);
+  lock_release (&ring->lock);
+
+  /* Unmap the pages so that pagedir_destroy() does not free them
+     a second time. */
+  for (i = 0; i < ring->page_cnt; i++)
+    pagedir_clear_page (t->pagedir, (uint8_t *) ring->uaddr + i * PGSIZE);
+  palloc_free_multiple (ring->hdr, ring->page_cnt);
+  t->ioring = NULL;
+  free (ring);
+}
+
+/* Appends a completion carrying USER_DATA and RES to RING's
+   completion queue, ending one of RING's requests in flight. */
+static void
+post_completion (struct ioring *ring, uint32_t user_data, int32_t res)
+{
+  struct io_ring_hdr *hdr = ring->hdr;
+  struct io_cqe *cqe;
+
+  lock_acquire (&ring->lock);
+  cqe = &hdr->cq[ring->cq_tail % IORING_CQ_ENTRIES];
+  cqe->user_data = user_data;
+  cqe->res = res;
+  barrier ();
+  hdr->cq_tail = ++ring->cq_tail;
+  ring->inflight--;
+  cond_broadcast (&ring->done, &ring->lock);
+  lock_release (&ring->lock);
+}
+
+/* Carries out request R and returns its result. */
+static int32_t
+execute_request (struct io_request *r)
+{
+  const struct io_sqe *sqe = &r->sqe;
+  uint8_t *buf = r->ring->bufs + sqe->buf;
+  int32_t res = 0;
+
+  lock_acquire (&filesys_lock);
+  switch (sqe->opcode)
+    {
+    case IO_OP_READ:
+      res = file_read_at (r->file, buf, sqe->len, sqe->offset);
+      break;
+    case IO_OP_WRITE:
+      res = file_write_at (r->file, buf, sqe->len, sqe->offset);
+      break;
+    case IO_OP_FSYNC:
+#ifdef CFILESYS
+      disk_cache_flush ();
+#endif
+      break;
+    default:
+      NOT_REACHED ();
+    }
+  file_close (r->file);
+  lock_release (&filesys_lock);
+  return res;
+}
+
+/* A worker thread.  Executes queued requests forever. */
+static void
+worker (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct io_request *r;
+      struct ioring *ring;
+      uint32_t user_data;
+      int32_t res;
+
+      lock_acquire (&work_lock);
+      while (list_empty (&work_queue))
+        cond_wait (&work_ready, &work_lock);
+      r = list_entry (list_pop_front (&work_queue), struct io_request, elem);
+      lock_release (&work_lock);
+
+      res = execute_request (r);
+      ring = r->ring;
+      user_data = r->sqe.user_data;
+      slab_free (&request_cache, r);
+
+      /* The ring may be freed as soon as this returns. */
+      post_completion (ring, user_data, res);
+    }
+}
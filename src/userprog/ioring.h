@@ -0,0 +1,15 @@
+#ifndef USERPROG_IORING_H
+#define USERPROG_IORING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Asynchronous I/O rings.  See lib/ioring.h for the layout
+   shared with user space. */
+
+void ioring_init (void);
+bool ioring_setup (void *uaddr, size_t buf_pages);
+int ioring_enter (size_t to_submit, size_t min_complete);
+void ioring_destroy (void);
+
+#endif /* userprog/ioring.h */
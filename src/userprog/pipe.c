@@ -0,0 +1,264 @@
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <stdint.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/syscall.h"
+#include "userprog/uaccess.h"
+
+/* A pipe.
+
+   Data lives in a one-page ring indexed by free-running read and
+   write counters; byte I is at offset I % PGSIZE.  Readers block
+   while the ring is empty and some write end is open; writers
+   block while it is full and some read end is open.
+
+   read() and write() on a pipe copy directly between user memory
+   and the ring.  splice() between a pipe and a file moves data
+   between the ring and the file system with no user copy at
+   all, up to a whole page of the ring per call. */
+struct pipe
+  {
+    uint8_t *buf;               /* Ring buffer, one page. */
+    uint32_t read_pos;          /* Total bytes read. */
+    uint32_t write_pos;         /* Total bytes written. */
+    int readers;                /* Open read ends. */
+    int writers;                /* Open write ends. */
+    struct lock lock;           /* Protects all of the above. */
+    struct condition not_empty; /* Signaled when data arrives. */
+    struct condition not_full;  /* Signaled when space appears. */
+  };
+
+/* Creates a pipe with one read end and one write end open.
+   Returns the new pipe, or a null pointer if memory is short. */
+struct pipe *
+pipe_create (void)
+{
+  struct pipe *p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+  p->buf = palloc_get_page (0);
+  if (p->buf == NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  p->read_pos = p->write_pos = 0;
+  p->readers = p->writers = 1;
+  lock_init (&p->lock);
+  cond_init (&p->not_empty);
+  cond_init (&p->not_full);
+  return p;
+}
+
+/* Records that another read end (or write end, if WRITER) of P
+   has been opened. */
+void
+pipe_open_end (struct pipe *p, bool writer)
+{
+  lock_acquire (&p->lock);
+  if (writer)
+    p->writers++;
+  else
+    p->readers++;
+  lock_release (&p->lock);
+}
+
+/* Closes a read end (or write end, if WRITER) of P, waking any
+   thread that was waiting on the other end, and frees P once no
+   ends remain open. */
+void
+pipe_close_end (struct pipe *p, bool writer)
+{
+  bool dead;
+
+  lock_acquire (&p->lock);
+  if (writer)
+    {
+      ASSERT (p->writers > 0);
+      p->writers--;
+      cond_broadcast (&p->not_empty, &p->lock);
+    }
+  else
+    {
+      ASSERT (p->readers > 0);
+      p->readers--;
+      cond_broadcast (&p->not_full, &p->lock);
+    }
+  dead = p->readers == 0 && p->writers == 0;
+  lock_release (&p->lock);
+
+  if (dead)
+    {
+      palloc_free_page (p->buf);
+      free (p);
+    }
+}
+
+/* Waits until P holds data or has no write ends left, and
+   returns the number of bytes available, 0 meaning end of file.
+   P's lock must be held. */
+static size_t
+wait_readable (struct pipe *p)
+{
+  while (p->write_pos == p->read_pos && p->writers > 0)
+    cond_wait (&p->not_empty, &p->lock);
+  return p->write_pos - p->read_pos;
+}
+
+/* Waits until P has free space or has no read ends left, and
+   returns the number of free bytes, 0 meaning nobody will read
+   them.  P's lock must be held. */
+static size_t
+wait_writable (struct pipe *p)
+{
+  while (p->write_pos - p->read_pos == PGSIZE && p->readers > 0)
+    cond_wait (&p->not_full, &p->lock);
+  return p->readers > 0 ? PGSIZE - (p->write_pos - p->read_pos) : 0;
+}
+
+/* Returns how many of the SIZE bytes starting at ring position
+   POS lie before the ring wraps. */
+static size_t
+contiguous (uint32_t pos, size_t size)
+{
+  size_t left = PGSIZE - pos % PGSIZE;
+  return size < left ? size : left;
+}
+
+/* Reads up to SIZE bytes from P into user buffer UBUF, waiting
+   for data if P is empty.  Returns the number of bytes read, 0
+   at end of file.  Terminates the process if UBUF is a bad
+   pointer. */
+int
+pipe_read (struct pipe *p, void *ubuf, size_t size)
+{
+  uint8_t *dst = ubuf;
+  size_t n, done;
+
+  lock_acquire (&p->lock);
+  n = wait_readable (p);
+  if (n > size)
+    n = size;
+  for (done = 0; done < n; )
+    {
+      size_t chunk = contiguous (p->read_pos + done, n - done);
+      if (!copy_to_user (dst + done, p->buf + (p->read_pos + done) % PGSIZE,
+                         chunk))
+        {
+          lock_release (&p->lock);
+          thread_exit ();
+        }
+      done += chunk;
+    }
+  p->read_pos += n;
+  cond_broadcast (&p->not_full, &p->lock);
+  lock_release (&p->lock);
+  return n;
+}
+
+/* Writes SIZE bytes from user buffer UBUF to P, waiting for
+   space as needed.  Returns SIZE, or fewer if every read end is
+   closed part way, or -1 if none was open to begin with.
+   Terminates the process if UBUF is a bad pointer. */
+int
+pipe_write (struct pipe *p, const void *ubuf, size_t size)
+{
+  const uint8_t *src = ubuf;
+  size_t written = 0;
+
+  lock_acquire (&p->lock);
+  while (written < size)
+    {
+      size_t n = wait_writable (p);
+      size_t done;
+
+      if (n == 0)
+        break;
+      if (n > size - written)
+        n = size - written;
+      for (done = 0; done < n; )
+        {
+          size_t chunk = contiguous (p->write_pos + done, n - done);
+          if (!copy_from_user (p->buf + (p->write_pos + done) % PGSIZE,
+                               src + written + done, chunk))
+            {
+              lock_release (&p->lock);
+              thread_exit ();
+            }
+          done += chunk;
+        }
+      p->write_pos += n;
+      written += n;
+      cond_broadcast (&p->not_empty, &p->lock);
+    }
+  lock_release (&p->lock);
+  return written > 0 || size == 0 ? (int) written : -1;
+}
+
+/* Moves up to SIZE bytes from P to FILE at its current position,
+   waiting for data if P is empty.  Returns the number of bytes
+   moved, 0 at end of file. */
+int
+pipe_splice_to_file (struct pipe *p, struct file *file, size_t size)
+{
+  size_t n, done = 0;
+
+  lock_acquire (&p->lock);
+  n = wait_readable (p);
+  if (n > size)
+    n = size;
+  lock_acquire (&filesys_lock);
+  while (done < n)
+    {
+      size_t chunk = contiguous (p->read_pos, n - done);
+      off_t written = file_write (file, p->buf + p->read_pos % PGSIZE, chunk);
+      p->read_pos += written;
+      done += written;
+      if ((size_t) written < chunk)
+        break;
+    }
+  lock_release (&filesys_lock);
+  cond_broadcast (&p->not_full, &p->lock);
+  lock_release (&p->lock);
+  return done;
+}
+
+/* Moves up to SIZE bytes from FILE at its current position into
+   P, waiting for space if P is full.  Returns the number of
+   bytes moved, 0 at end of FILE, or -1 if P has no read end
+   open. */
+int
+pipe_splice_from_file (struct pipe *p, struct file *file, size_t size)
+{
+  size_t n, done = 0;
+
+  lock_acquire (&p->lock);
+  n = wait_writable (p);
+  if (n == 0)
+    {
+      lock_release (&p->lock);
+      return -1;
+    }
+  if (n > size)
+    n = size;
+  lock_acquire (&filesys_lock);
+  while (done < n)
+    {
+      size_t chunk = contiguous (p->write_pos, n - done);
+      off_t bytes_read = file_read (file, p->buf + p->write_pos % PGSIZE,
+                                    chunk);
+      p->write_pos += bytes_read;
+      done += bytes_read;
+      if ((size_t) bytes_read < chunk)
+        break;
+    }
+  lock_release (&filesys_lock);
+  cond_broadcast (&p->not_empty, &p->lock);
+  lock_release (&p->lock);
+  return done;
+}
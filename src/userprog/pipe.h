@@ -0,0 +1,18 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct file;
+
+/* Pipes. */
+struct pipe *pipe_create (void);
+void pipe_open_end (struct pipe *, bool writer);
+void pipe_close_end (struct pipe *, bool writer);
+int pipe_read (struct pipe *, void *ubuf, size_t size);
+int pipe_write (struct pipe *, const void *ubuf, size_t size);
+int pipe_splice_to_file (struct pipe *, struct file *, size_t size);
+int pipe_splice_from_file (struct pipe *, struct file *, size_t size);
+
+#endif /* userprog/pipe.h */
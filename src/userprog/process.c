@@ -5,7 +5,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "userprog/elfcache.h"
 #include "userprog/gdt.h"
+#include "userprog/ioring.h"
 #include "userprog/pagedir.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
@@ -17,12 +19,15 @@
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "threads/synch.h"
 #include "threads/malloc.h"
 #include "userprog/syscall.h"
 #ifdef VM
 #include "vm/page.h"
 #include "vm/frame.h"
+#include "vm/shm.h"
+#include "vm/cow.h"
 #include <hash.h>
 #endif
 static thread_func start_process NO_RETURN;
@@ -37,7 +42,7 @@ process_execute (const char *file_name)
 {
   char *fn_copy, *unused;
   tid_t tid;
-  void *arr[3];
+  void *arr[4];
   bool load_fail = false;
   struct semaphore start_sema;
  
@@ -56,6 +61,7 @@ process_execute (const char *file_name)
   arr[0] = fn_copy;
   arr[1] = &start_sema;
   arr[2] = &load_fail;
+  arr[3] = thread_current ();
   lock_acquire(&process_execute_lock);
   tid = thread_create (fn_copy, PRI_DEFAULT, start_process, arr);
   lock_release(&process_execute_lock);
@@ -75,6 +81,7 @@ start_process (void *args)
   struct thread *t = thread_current();
   struct semaphore *start_sema = ((struct semaphore **)args)[1];
   bool *load_fail = ((bool **)args)[2];
+  struct thread *parent = ((struct thread **)args)[3];
   bool success;
 
   /* Initialize interrupt frame and load executable. */
@@ -107,11 +114,100 @@ start_process (void *args)
       thread_current()->CWD = dir_open_root();
   }
 #endif
+  /* A process started by another inherits its descriptors. */
+  if(parent->pagedir != NULL)
+      inherit_fds(parent);
   sema_up(start_sema);
   asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
   NOT_REACHED ();
 }
 
+#ifdef VM
+static thread_func start_fork NO_RETURN;
+
+/* Creates a child process that is a copy of the current one,
+   sharing its memory copy-on-write.  The child resumes from
+   interrupt frame F with 0 in eax.  Returns the child's thread
+   id, or TID_ERROR if it cannot be created. */
+tid_t
+process_fork (const struct intr_frame *f)
+{
+  struct thread *curr = thread_current ();
+  tid_t tid;
+  void *arr[4];
+  bool load_fail = false;
+  struct semaphore start_sema;
+
+  sema_init(&start_sema, 0);
+  arr[0] = (void *)f;
+  arr[1] = &start_sema;
+  arr[2] = &load_fail;
+  arr[3] = curr;
+  lock_acquire(&process_execute_lock);
+  tid = thread_create (curr->name, PRI_DEFAULT, start_fork, arr);
+  lock_release(&process_execute_lock);
+  if (tid == TID_ERROR)
+    return TID_ERROR;
+  /* The parent must not run until its pages are all shared. */
+  sema_down(&start_sema);
+  if(load_fail == true) tid = TID_ERROR;
+  return tid;
+}
+
+/* A thread function that copies the forking parent's process
+   and makes it start running. */
+static void
+start_fork (void *args)
+{
+  struct intr_frame if_;
+  struct thread *t = thread_current();
+  struct semaphore *start_sema = ((struct semaphore **)args)[1];
+  bool *load_fail = ((bool **)args)[2];
+  struct thread *parent = ((struct thread **)args)[3];
+  bool success = false;
+
+  memcpy (&if_, ((struct intr_frame **)args)[0], sizeof if_);
+  if_.eax = 0;
+
+  t->pagedir = pagedir_create ();
+  if (t->pagedir == NULL)
+    goto done;
+  process_activate ();
+
+  lock_acquire(&filesys_lock);
+  if(parent->executable != NULL)
+  {
+      t->executable = file_reopen(parent->executable);
+      if(t->executable != NULL)
+        file_deny_write(t->executable);
+  }
+  lock_release(&filesys_lock);
+  if(parent->executable != NULL && t->executable == NULL)
+    goto done;
+
+  success = cow_fork(parent, t->executable) && shm_fork(parent);
+
+ done:
+  if (!success)
+  {
+      *load_fail = true;
+      list_remove(&t->child_elem);
+      sema_up(start_sema);
+      t->load_fail = true;
+      thread_exit ();
+      NOT_REACHED();
+  }
+
+#ifdef EFILESYS
+  t->CWD = parent->CWD != NULL ? dir_reopen(parent->CWD) : dir_open_root();
+#endif
+  inherit_fds(parent);
+  sema_up(start_sema);
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+#endif
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
@@ -157,15 +253,18 @@ process_exit (void)
   uint32_t *pd;
   struct fd_wrap *wrapper;
 
-  if(!lock_held_by_current_thread(&filesys_lock))
-      lock_acquire(&filesys_lock);
+  /* Requests still in flight on the ring need filesys_lock to
+     finish, and fd_free() must not be called with it held. */
+  if(lock_held_by_current_thread(&filesys_lock))
+      lock_release(&filesys_lock);
+  ioring_destroy();
 
   while(!list_empty(&curr->fd_list))
   {
       wrapper = list_entry(list_pop_front(&curr->fd_list), struct fd_wrap, elem);
-      file_close(wrapper->file);
-      free(wrapper);
+      fd_free(wrapper);
   }
+  lock_acquire(&filesys_lock);
 #ifdef VM
   struct mmap_wrap *mwrapper;
   while(!list_empty(&curr->mmap_list))
@@ -195,11 +294,13 @@ process_exit (void)
       if(hash_next(&iter))
         destroy_alloc(hash_cur(&iter));
   }
+  shm_exit();
   lock_release(&page_lock);
 #endif
 
   if(curr->load_fail == false)
   {
+      sema_clear_owner(&curr->wait_sema);
       sema_up(&curr->wait_sema);
       printf("%s: exit(%d)\n", curr->name, curr->exit_state);
       sema_down(&curr->fin_sema);
@@ -300,7 +401,18 @@ struct Elf32_Phdr
 #define PF_W 2          /* Writable. */
 #define PF_R 4          /* Readable. */
 
+/* Program headers read at a time. */
+#define PHDR_BATCH 16
+
+/* Statistics. */
+static long long load_cnt;      /* Successful loads. */
+static long long load_hit_cnt;  /* ...of which found in the ELF cache. */
+static long long load_ns;       /* Nanoseconds spent in those loads. */
+static long long load_hit_ns;   /* ...and in the cached ones. */
+
 static bool setup_stack (void **esp);
+static bool read_layout (const char *file_name, struct file *,
+                         struct elf_layout *);
 static bool validate_segment (const struct Elf32_Phdr *, struct file *);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
                           uint32_t read_bytes, uint32_t zero_bytes,
@@ -402,11 +514,12 @@ bool
 load (const char *file_name, void (**eip) (void), void **esp) 
 {
   struct thread *t = thread_current ();
-  struct Elf32_Ehdr ehdr;
+  struct elf_layout layout;
   struct file *file = NULL;
-  off_t file_ofs;
+  int64_t start = timer_nanos ();
   bool success = false;
-  int i;
+  bool hit = false;
+  size_t i;
 
   /* Allocate and activate page directory. */
   t->pagedir = pagedir_create ();
@@ -422,8 +535,69 @@ load (const char *file_name, void (**eip) (void), void **esp)
       goto done; 
     }
 
+  /* Find the loadable segments, reading the headers only if
+     this executable's layout is not cached. */
+  hit = elf_cache_lookup (file_get_inode (file), &layout);
+  if (!hit)
+    {
+      if (!read_layout (file_name, file, &layout))
+        goto done;
+      elf_cache_insert (file_get_inode (file), &layout);
+    }
+
+  for (i = 0; i < layout.seg_cnt; i++)
+    {
+      const struct elf_segment *seg = &layout.segs[i];
+      if (!load_segment (file, seg->file_page, (void *) seg->mem_page,
+                         seg->read_bytes, seg->zero_bytes, seg->writable))
+        goto done;
+    }
+
+  /* Set up stack. */
+  if (!setup_stack (esp))
+    goto done;
+  setup_args(esp, file_name);
+  /* Start address. */
+  *eip = (void (*) (void)) layout.entry;
+
+  success = true;
+
+ done:
+  /* We arrive here whether the load is successful or not. */
+  if(file != NULL)
+  {
+    t->executable = file;
+    file_deny_write(file);
+  }
+  if (success)
+    {
+      int64_t ns = timer_nanos () - start;
+      load_cnt++;
+      load_ns += ns;
+      if (hit)
+        {
+          load_hit_cnt++;
+          load_hit_ns += ns;
+        }
+    }
+  lock_release(&filesys_lock);
+  return success;
+}
+
+/* Reads and validates the ELF header and program headers of
+   FILE, named FILE_NAME, into *LAYOUT.  Returns true if FILE is
+   a loadable executable, false otherwise. */
+static bool
+read_layout (const char *file_name, struct file *file,
+             struct elf_layout *layout)
+{
+  struct Elf32_Ehdr ehdr;
+  struct Elf32_Phdr phdrs[PHDR_BATCH];
+  off_t file_ofs;
+  int i;
+
   /* Read and verify executable header. */
-  if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
+  if (file_read_at (file, &ehdr, sizeof ehdr, 0) != sizeof ehdr
       || memcmp (ehdr.e_ident, "\177ELF\1\1\1", 7)
       || ehdr.e_type != 2
       || ehdr.e_machine != 3
@@ -432,23 +606,29 @@ load (const char *file_name, void (**eip) (void), void **esp)
       || ehdr.e_phnum > 1024) 
     {
       printf ("load: %s: error loading executable\n", file_name);
-      goto done; 
+      return false;
     }
 
-  /* Read program headers. */
+  /* Read program headers, PHDR_BATCH at a time. */
+  layout->entry = ehdr.e_entry;
+  layout->seg_cnt = 0;
   file_ofs = ehdr.e_phoff;
+  if (file_ofs < 0 || file_ofs > file_length (file))
+    return false;
   for (i = 0; i < ehdr.e_phnum; i++) 
     {
-      struct Elf32_Phdr phdr;
-
-      if (file_ofs < 0 || file_ofs > file_length (file))
-        goto done;
-      file_seek (file, file_ofs);
+      struct Elf32_Phdr *phdr = &phdrs[i % PHDR_BATCH];
 
-      if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-        goto done;
-      file_ofs += sizeof phdr;
-      switch (phdr.p_type) 
+      if (i % PHDR_BATCH == 0)
+        {
+          int cnt = ehdr.e_phnum - i < PHDR_BATCH ? ehdr.e_phnum - i
+                                                  : PHDR_BATCH;
+          off_t size = cnt * sizeof *phdrs;
+          if (file_read_at (file, phdrs, size, file_ofs) != size)
+            return false;
+          file_ofs += size;
+        }
+      switch (phdr->p_type) 
         {
         case PT_NULL:
         case PT_NOTE:
@@ -460,58 +640,55 @@ load (const char *file_name, void (**eip) (void), void **esp)
         case PT_DYNAMIC:
         case PT_INTERP:
         case PT_SHLIB:
-          goto done;
+          return false;
         case PT_LOAD:
-          if (validate_segment (&phdr, file)) 
+          if (validate_segment (phdr, file)
+              && layout->seg_cnt < ELF_SEGS_MAX) 
             {
-              bool writable = (phdr.p_flags & PF_W) != 0;
-              uint32_t file_page = phdr.p_offset & ~PGMASK;
-              uint32_t mem_page = phdr.p_vaddr & ~PGMASK;
-              uint32_t page_offset = phdr.p_vaddr & PGMASK;
-              uint32_t read_bytes, zero_bytes;
-              if (phdr.p_filesz > 0)
+              struct elf_segment *seg = &layout->segs[layout->seg_cnt++];
+              uint32_t page_offset = phdr->p_vaddr & PGMASK;
+              seg->writable = (phdr->p_flags & PF_W) != 0;
+              seg->file_page = phdr->p_offset & ~PGMASK;
+              seg->mem_page = phdr->p_vaddr & ~PGMASK;
+              if (phdr->p_filesz > 0)
                 {
                   /* Normal segment.
                      Read initial part from disk and zero the rest. */
-                  read_bytes = page_offset + phdr.p_filesz;
-                  zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-                                - read_bytes);
+                  seg->read_bytes = page_offset + phdr->p_filesz;
+                  seg->zero_bytes = (ROUND_UP (page_offset + phdr->p_memsz,
+                                               PGSIZE)
+                                     - seg->read_bytes);
                 }
               else 
                 {
                   /* Entirely zero.
                      Don't read anything from disk. */
-                  read_bytes = 0;
-                  zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
+                  seg->read_bytes = 0;
+                  seg->zero_bytes = ROUND_UP (page_offset + phdr->p_memsz,
+                                              PGSIZE);
                 }
-              if (!load_segment (file, file_page, (void *) mem_page,
-                                 read_bytes, zero_bytes, writable))
-                goto done;
             }
           else
-            goto done;
+            return false;
           break;
         }
     }
+  return true;
+}
 
-  /* Set up stack. */
-  if (!setup_stack (esp))
-    goto done;
-  setup_args(esp, file_name);
-  /* Start address. */
-  *eip = (void (*) (void)) ehdr.e_entry;
-
-  success = true;
-
- done:
-  /* We arrive here whether the load is successful or not. */
-  if(file != NULL)
-  {
-    t->executable = file;
-    file_deny_write(file);
-  }
-  lock_release(&filesys_lock);
-  return success;
+/* Prints statistics about loading executables. */
+void
+process_print_stats (void)
+{
+  long long miss_cnt = load_cnt - load_hit_cnt;
+
+  if (load_cnt == 0)
+    return;
+  printf ("Exec: %lld loads, %lld from the ELF cache; "
+          "avg load %lld ns (cached %lld ns, uncached %lld ns)\n",
+          load_cnt, load_hit_cnt, load_ns / load_cnt,
+          load_hit_cnt ? load_hit_ns / load_hit_cnt : 0,
+          miss_cnt ? (load_ns - load_hit_ns) / miss_cnt : 0);
 }
 
 /* load() helpers. */
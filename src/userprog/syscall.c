@@ -11,35 +11,76 @@
 #include "lib/string.h"
 #include "filesys/directory.h"
 #include "filesys/inode.h"
+#include "userprog/pagedir.h"
 #include "userprog/process.h"
+#include "userprog/uaccess.h"
+#include "userprog/ioring.h"
+#include "userprog/pipe.h"
+#include "userprog/elfcache.h"
 #include "devices/input.h"
+#include "devices/timer.h"
+#include "threads/vaddr.h"
 #ifdef VM
 #include "vm/page.h"
 #include "vm/frame.h"
 #include "vm/swap.h"
-#include "threads/vaddr.h"
-#include "userprog/pagedir.h"
+#include "vm/shm.h"
 #endif
 #ifdef EFILESYS
 #include "filesys/inode.h"
 #endif
 typedef int pid_t;
 
+/* Bytes of user buffer a transfer pins at a time. */
+#define PIN_CHUNK (16 * PGSIZE)
+
+struct slab_cache fd_cache;
+
 static void syscall_handler (struct intr_frame *);
-static void check_args(void *esp, uint32_t argc);
+static void check_args(void *esp, uint32_t *args, uint32_t argc);
 
 void
 syscall_init (void) 
 {
   lock_init(&filesys_lock);
+  slab_cache_init(&fd_cache, "fd", sizeof(struct fd_wrap), 0);
+  ioring_init();
+  elf_cache_init();
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
 }
 
+/* Copies the syscall number and the ARGC - 1 arguments above it
+   on the user stack at ESP into ARGS.  Handlers read their
+   arguments from this kernel copy.  Terminates the process if
+   the stack words are not all mapped user memory. */
+static void
+check_args(void *esp, uint32_t *args, uint32_t argc)
+{
+    if(!copy_from_user(args, esp, argc * sizeof *args))
+        thread_exit();
+}
+
+/* Copies the string at user address USTR into DST, which has
+   room for SIZE bytes.  Returns false if the string does not
+   fit.  Terminates the process if USTR is a bad pointer. */
+static bool
+get_user_string(char *dst, const char *ustr, size_t size)
+{
+    int len = strncpy_from_user(dst, ustr, size);
+    if(len < 0)
+        thread_exit();
+    return (size_t)len < size;
+}
+
+/* Terminates the process unless the SIZE bytes at user address
+   UADDR lie below PHYS_BASE.  This is only a cheap first check:
+   file data moves through pinned_io(), which faults in and pins
+   each chunk of the buffer before taking filesys_lock, so the file
+   system never touches user memory that is not resident. */
 static void
-check_args(void *esp, uint32_t argc)
+check_user_range(const void *uaddr, size_t size)
 {
-    uint32_t _esp = (uint32_t)esp;
-    if((_esp + (argc << 2)) >= 0xc0000000)
+    if(!is_user_range(uaddr, size))
         thread_exit();
 }
 /* for sys_halt */
@@ -51,24 +92,27 @@ _halt(void)
 
 /* for sys_exit */
 static void
-_exit(void *esp)
+_exit(void *args)
 {
     struct thread *t = thread_current();
-    int32_t ret = *(const int32_t *)(esp + 4);
+    int32_t ret = *(const int32_t *)(args + 4);
     t->exit_state = ret;
     thread_exit();
 }
 
 /* for sys_exec */
 static pid_t
-_exec(void *esp)
+_exec(void *args)
 {
-    const char *file_name = *(const char **)(esp + 4);
+    const char *ucmd_line = *(const char **)(args + 4);
+    char cmd_line[0x100];
     char fn_copy[0x100];
     char *name;
     char *unused;
     bool check_exists = false;
-    strlcpy(fn_copy, file_name, 0x100);
+    if(!get_user_string(cmd_line, ucmd_line, sizeof cmd_line))
+        return -1;
+    strlcpy(fn_copy, cmd_line, sizeof fn_copy);
     name = strtok_r(fn_copy, " ", &unused);
 
     lock_acquire(&filesys_lock);
@@ -79,34 +123,39 @@ _exec(void *esp)
     dir_close(dir);
     inode_close (inode);
     lock_release(&filesys_lock);
-    return check_exists == true ? process_execute(file_name) : -1;
+    return check_exists == true ? process_execute(cmd_line) : -1;
 }
 
 /* for sys_wait */
 static int
-_wait(void *esp)
+_wait(void *args)
 {
-    pid_t pid = *(pid_t *)(esp + 4);
+    pid_t pid = *(pid_t *)(args + 4);
 
     return process_wait(pid);
 }
 
 /* for sys_create */
 static bool
-_create(void *esp)
+_create(void *args)
 {
-    const char *file_name = *(const char **)(esp + 4);
-    unsigned initial_size = *(unsigned *)(esp + 8);
-    if(file_name == NULL || !strcmp(file_name, "")) thread_exit();
+    const char *ufile_name = *(const char **)(args + 4);
+    unsigned initial_size = *(unsigned *)(args + 8);
+    char file_name[0x100];
+    if(!get_user_string(file_name, ufile_name, sizeof file_name))
+        return false;
+    if(!strcmp(file_name, "")) thread_exit();
     lock_acquire(&filesys_lock);
     return filesys_create(file_name, initial_size);
 }
 /* for sys_remove */
 static bool
-_remove(void *esp)
+_remove(void *args)
 {
-    const char *file_name = *(const char **)(esp + 4);
-    if(file_name == NULL) return false;
+    const char *ufile_name = *(const char **)(args + 4);
+    char file_name[0x100];
+    if(!get_user_string(file_name, ufile_name, sizeof file_name))
+        return false;
     lock_acquire(&filesys_lock);
 #ifdef EFILESYS
     struct file *file = filesys_open(file_name);
@@ -118,7 +167,7 @@ _remove(void *esp)
         for(e = list_begin(fd_list); e != list_end(fd_list); e = list_next(e))
         {
             wrapper = list_entry(e, struct fd_wrap, elem);
-            if(file_get_inode(wrapper->file) == file_get_inode(file))
+            if(wrapper->file != NULL && file_get_inode(wrapper->file) == file_get_inode(file))
             {
                 file_close(file);
                 return false;
@@ -142,7 +191,9 @@ fd_sort(const struct list_elem *A, const struct list_elem *B, void *aux)
     return(fdA->fd < fdB->fd)? true:false;
 }
 
-static struct fd_wrap *
+/* Returns the current process's descriptor FD, or NULL if it is
+   not open. */
+struct fd_wrap *
 get_fd_wrapper_by_fd(int32_t fd)
 {
     struct list *fd_list = &thread_current()->fd_list;
@@ -168,6 +219,9 @@ allocate_fd(void)
     for(e = list_begin(fd_list); e != list_end(fd_list); e = list_next(e))
     {
         wrapper = list_entry(e, struct fd_wrap, elem);
+        /* Skip a redirected standard input or output. */
+        if(wrapper->fd < __fd)
+            continue;
         if(wrapper->fd != __fd)
             break;
         __fd++;
@@ -175,16 +229,18 @@ allocate_fd(void)
     return __fd;
 }
 
+/* Opens the file named by user string UFILE_NAME and returns a
+   new descriptor with O_* FLAGS, or -1 on failure. */
 static int
-_open(void *esp)
+open_fd(const char *ufile_name, int flags)
 {
-    const char *file_name = *(const char **)(esp + 4);
+    char file_name[0x100];
     struct file *file = NULL;
     struct fd_wrap *wrapper = NULL;
     struct thread *t = thread_current();
-    if(file_name == NULL)
+    if(!get_user_string(file_name, ufile_name, sizeof file_name))
     {
-        thread_exit();
+        return -1;
     }
     if(!strcmp(file_name, ""))
     {
@@ -197,7 +253,7 @@ _open(void *esp)
         return -1;
     }
 
-    wrapper = (struct fd_wrap *)malloc(sizeof(struct fd_wrap));
+    wrapper = slab_alloc(&fd_cache);
     if(wrapper == NULL)
     {
         file_close(file);
@@ -205,6 +261,9 @@ _open(void *esp)
     }
     wrapper->file = file;
     wrapper->fd = allocate_fd();
+    wrapper->flags = flags;
+    wrapper->pipe = NULL;
+    wrapper->writer = false;
 #ifdef EFILESYS
     wrapper->dir = is_inode_dir(file_get_inode(file)) ? dir_open(file_get_inode(file)) : NULL;
 #endif
@@ -212,115 +271,580 @@ _open(void *esp)
     return wrapper->fd;
 }
 
+/* for sys_open */
+static int
+_open(void *args)
+{
+    const char *ufile_name = *(const char **)(args + 4);
+    return open_fd(ufile_name, 0);
+}
+
+/* for sys_open_flags */
+static int
+_open_flags(void *args)
+{
+    const char *ufile_name = *(const char **)(args + 4);
+    int flags = *(int *)(args + 8);
+    if(flags & ~O_DIRECT)
+        return -1;
+    return open_fd(ufile_name, flags);
+}
+
 static void
-_close(void *esp)
+_close(void *args)
 {
-    int32_t fd = *(int32_t *)(esp + 4);
+    int32_t fd = *(int32_t *)(args + 4);
     struct fd_wrap *fd_wrapper;
-    lock_acquire(&filesys_lock);
     fd_wrapper = get_fd_wrapper_by_fd(fd);
     if(fd_wrapper)
     {
-        file_close(fd_wrapper->file);
+        list_remove(&fd_wrapper->elem);
+        fd_free(fd_wrapper);
+    }
+}
+
+/* Closes descriptor WRAPPER, which must already be off its
+   fd_list, and frees it.  Must be called without filesys_lock
+   held: pipe_splice_to_file() and pipe_splice_from_file() take
+   filesys_lock while holding a pipe's lock, so closing a pipe end
+   under filesys_lock could deadlock. */
+void
+fd_free(struct fd_wrap *wrapper)
+{
+    if(wrapper->pipe != NULL)
+        pipe_close_end(wrapper->pipe, wrapper->writer);
+    else
+    {
+        lock_acquire(&filesys_lock);
+        file_close(wrapper->file);
+        lock_release(&filesys_lock);
 #ifdef EFILESYS
-        if(fd_wrapper->dir)
-            free(fd_wrapper->dir);
+        if(wrapper->dir)
+            free(wrapper->dir);
 #endif
-        list_remove(&fd_wrapper->elem);
-        free(fd_wrapper);
+    }
+    slab_free(&fd_cache, wrapper);
+}
+
+/* Returns a new descriptor numbered FD for the same file or pipe
+   end as SRC, not yet on any fd_list, or NULL if memory is
+   short.  A file is reopened, so the copy has a position of its
+   own, starting where SRC's is.  Must be called without
+   filesys_lock held. */
+static struct fd_wrap *
+dup_fd(const struct fd_wrap *src, int fd)
+{
+    struct fd_wrap *wrapper = slab_alloc(&fd_cache);
+    if(wrapper == NULL)
+        return NULL;
+    *wrapper = *src;
+    wrapper->fd = fd;
+    if(src->pipe != NULL)
+    {
+        pipe_open_end(src->pipe, src->writer);
+        return wrapper;
+    }
+
+    lock_acquire(&filesys_lock);
+    wrapper->file = file_reopen(src->file);
+    if(wrapper->file != NULL)
+        file_seek(wrapper->file, file_tell(src->file));
+#ifdef EFILESYS
+    if(wrapper->file != NULL && src->dir != NULL)
+        wrapper->dir = dir_open(file_get_inode(wrapper->file));
+#endif
+    lock_release(&filesys_lock);
+    if(wrapper->file == NULL)
+    {
+        slab_free(&fd_cache, wrapper);
+        return NULL;
+    }
+    return wrapper;
+}
+
+/* Gives the current process, which exec() is starting, a copy of
+   each of PARENT's descriptors under the same number.  Called
+   while PARENT waits for the load to finish, so its fd_list is
+   stable.  Descriptors that cannot be copied for lack of memory
+   are left closed. */
+void
+inherit_fds(struct thread *parent)
+{
+    struct list *fd_list = &thread_current()->fd_list;
+    struct list_elem *e;
+    for(e = list_begin(&parent->fd_list); e != list_end(&parent->fd_list); e = list_next(e))
+    {
+        struct fd_wrap *src = list_entry(e, struct fd_wrap, elem);
+        struct fd_wrap *wrapper = dup_fd(src, src->fd);
+        if(wrapper != NULL)
+            list_push_back(fd_list, &wrapper->elem);
     }
 }
 
+/* for sys_pipe */
+static bool
+_pipe(void *args)
+{
+    int *ufds = *(int **)(args + 4);
+    struct thread *t = thread_current();
+    struct fd_wrap *ends[2];
+    struct pipe *p;
+    int fds[2];
+    int i;
+
+    check_user_range(ufds, sizeof fds);
+    p = pipe_create();
+    if(p == NULL)
+        return false;
+    ends[0] = slab_alloc(&fd_cache);
+    ends[1] = slab_alloc(&fd_cache);
+    if(ends[0] == NULL || ends[1] == NULL)
+    {
+        slab_free(&fd_cache, ends[0]);
+        slab_free(&fd_cache, ends[1]);
+        pipe_close_end(p, false);
+        pipe_close_end(p, true);
+        return false;
+    }
+    for(i = 0; i < 2; i++)
+    {
+        ends[i]->file = NULL;
+        ends[i]->flags = 0;
+        ends[i]->pipe = p;
+        ends[i]->writer = i == 1;
+#ifdef EFILESYS
+        ends[i]->dir = NULL;
+#endif
+        ends[i]->fd = fds[i] = allocate_fd();
+        list_insert_ordered(&t->fd_list, &ends[i]->elem, fd_sort, NULL);
+    }
+    if(!copy_to_user(ufds, fds, sizeof fds))
+        thread_exit();
+    return true;
+}
+
+/* for sys_dup2 */
+static int
+_dup2(void *args)
+{
+    int32_t oldfd = *(int32_t *)(args + 4);
+    int32_t newfd = *(int32_t *)(args + 8);
+    struct fd_wrap *old = get_fd_wrapper_by_fd(oldfd);
+    struct fd_wrap *new, *prev;
+
+    if(old == NULL || newfd < 0)
+        return -1;
+    if(oldfd == newfd)
+        return newfd;
+    new = dup_fd(old, newfd);
+    if(new == NULL)
+        return -1;
+    prev = get_fd_wrapper_by_fd(newfd);
+    if(prev != NULL)
+    {
+        list_remove(&prev->elem);
+        fd_free(prev);
+    }
+    list_insert_ordered(&thread_current()->fd_list, &new->elem, fd_sort, NULL);
+    return newfd;
+}
+
+/* Returns true if WRAPPER is an open regular file, not a pipe or
+   a directory. */
+static bool
+is_regular_fd(const struct fd_wrap *wrapper)
+{
+    if(wrapper == NULL || wrapper->file == NULL)
+        return false;
+#ifdef EFILESYS
+    if(is_inode_dir(file_get_inode(wrapper->file)))
+        return false;
+#endif
+    return true;
+}
+
+/* for sys_splice */
+static int
+_splice(void *args)
+{
+    int32_t fd_in = *(int32_t *)(args + 4);
+    int32_t fd_out = *(int32_t *)(args + 8);
+    int32_t len = *(int32_t *)(args + 12);
+    struct fd_wrap *in = get_fd_wrapper_by_fd(fd_in);
+    struct fd_wrap *out = get_fd_wrapper_by_fd(fd_out);
+
+    if(in == NULL || out == NULL || len < 0)
+        return -1;
+    if(in->pipe != NULL && !in->writer && is_regular_fd(out))
+        return pipe_splice_to_file(in->pipe, out->file, len);
+    if(out->pipe != NULL && out->writer && is_regular_fd(in))
+        return pipe_splice_from_file(out->pipe, in->file, len);
+    return -1;
+}
+
 /* for sys_file_size */
 static int
-_file_size(void *esp)
+_file_size(void *args)
 {
-    int32_t fd = *(int32_t *)(esp + 4);
+    int32_t fd = *(int32_t *)(args + 4);
     struct fd_wrap *fd_wrapper;
     fd_wrapper = get_fd_wrapper_by_fd(fd);
     lock_acquire(&filesys_lock);
-    if(fd_wrapper != NULL)
+    if(fd_wrapper != NULL && fd_wrapper->file != NULL)
         return file_length(fd_wrapper->file);
     return -1;
 }
 
-/* for sys_read */
+/* Makes the SIZE bytes of user memory at UADDR resident, and
+   keeps them resident until unpin_user_buffer(), so that the
+   disk driver can transfer to or from them directly.  If WRITE,
+   the memory must be writable.  Returns false if any of it is
+   not valid user memory. */
+static bool
+pin_user_buffer(void *uaddr, size_t size, bool write)
+{
+#ifdef VM
+    return vm_pin_range(uaddr, size, write);
+#else
+    /* Without VM, user pages never leave memory; just check that
+       each one is mapped, and writable if WRITE. */
+    uint32_t *pd = thread_current()->pagedir;
+    uint8_t *p;
+    for(p = uaddr; p < (uint8_t *)uaddr + size; p = pg_round_down(p) + PGSIZE)
+    {
+        uint8_t c;
+        if(!copy_from_user(&c, p, 1)
+           || (write && !pagedir_is_writable(pd, pg_round_down(p))))
+            return false;
+    }
+    return true;
+#endif
+}
+
+static void
+unpin_user_buffer(void *uaddr UNUSED, size_t size UNUSED)
+{
+#ifdef VM
+    vm_unpin_range(uaddr, size);
+#endif
+}
+
+/* Transfers LEN bytes between FILE and user BUFFER: from FILE
+   to BUFFER, or the other way if WRITE.  The transfer starts at
+   OFFSET, or at FILE's position if OFFSET is negative, and moves
+   whole sectors straight between disk and BUFFER if DIRECT.
+
+   At most PIN_CHUNK bytes of BUFFER are pinned at a time, before
+   filesys_lock is taken.  A bad buffer therefore terminates the
+   process before any file system lock is held, and the buffer
+   cache never faults on user memory while holding its own.
+   Returns the number of bytes transferred. */
+static uint32_t
+pinned_io(struct file *file, void *buffer, uint32_t len, off_t offset,
+          bool write, bool direct)
+{
+    uint32_t done = 0;
+    while(done < len)
+    {
+        uint32_t chunk = len - done < PIN_CHUNK ? len - done : PIN_CHUNK;
+        off_t n;
+        if(!pin_user_buffer(buffer + done, chunk, !write))
+            thread_exit();
+        lock_acquire(&filesys_lock);
+        if(direct)
+            n = write ? file_write_direct(file, buffer + done, chunk)
+                      : file_read_direct(file, buffer + done, chunk);
+        else if(offset < 0)
+            n = write ? file_write(file, buffer + done, chunk)
+                      : file_read(file, buffer + done, chunk);
+        else
+            n = write ? file_write_at(file, buffer + done, chunk, offset + done)
+                      : file_read_at(file, buffer + done, chunk, offset + done);
+        lock_release(&filesys_lock);
+        unpin_user_buffer(buffer + done, chunk);
+        done += n;
+        if((uint32_t)n < chunk)
+            break;
+    }
+    return done;
+}
+
+/* Reads LEN bytes from FD into user BUFFER at the descriptor's
+   current position.  Returns the number of bytes read. */
 static int
-_read(void *esp)
+read_fd(int32_t fd, void *buffer, uint32_t len)
 {
-    int32_t fd = *(int32_t *)(esp + 4);
-    void *buffer = *(void **)(esp + 8);
-    uint32_t len = *(uint32_t *)(esp + 12);
     uint32_t ret = 0;
     struct fd_wrap *fd_wrapper;
 
-    if(fd == 0)
+    check_user_range(buffer, len);
+    /* Standard input and output are the console unless dup2() has
+       redirected them. */
+    fd_wrapper = get_fd_wrapper_by_fd(fd);
+    if(fd_wrapper == NULL && fd == 0)
     {
         for(ret = 0; ret < len; ret++)
         {
-            *(char *)(buffer + ret) = input_getc();
+            char c = input_getc();
+            if(!copy_to_user(buffer + ret, &c, 1))
+                thread_exit();
         }
             
     }
-    else if(fd == 1)
+    else if(fd_wrapper == NULL && fd == 1)
     {
         thread_exit();
     }
-    else
+    else if(fd_wrapper != NULL && fd_wrapper->pipe != NULL)
     {
-        fd_wrapper = get_fd_wrapper_by_fd(fd);
-        if(fd_wrapper != NULL)
-        {
-            lock_acquire(&filesys_lock);
-            ret = file_read(fd_wrapper->file, buffer, len);
-        }
+        return fd_wrapper->writer ? -1 : pipe_read(fd_wrapper->pipe, buffer, len);
+    }
+    else if(fd_wrapper != NULL)
+    {
+        ret = pinned_io(fd_wrapper->file, buffer, len, -1, false,
+                        fd_wrapper->flags & O_DIRECT);
     }
     return ret;
 }
 
-/* for sys_write */
+/* Writes LEN bytes from user BUFFER to FD at the descriptor's
+   current position.  Returns the number of bytes written, or -1
+   if FD is a directory. */
 static int
-_write(void *esp)
+write_fd(int32_t fd, void *buffer, uint32_t len)
 {
-    int32_t fd = *(int32_t *)(esp + 4);
-    void *buffer = *(void **)(esp + 8);
-    uint32_t len = *(uint32_t *)(esp + 12);
     uint32_t ret = 0;
     struct fd_wrap *fd_wrapper;
-    if(fd == 0)
+    check_user_range(buffer, len);
+    fd_wrapper = get_fd_wrapper_by_fd(fd);
+    if(fd_wrapper == NULL && fd == 0)
     {
         thread_exit();
     }
-    else if(fd ==1)
+    else if(fd_wrapper == NULL && fd ==1)
     {
-        putbuf(buffer, len);
+        /* putbuf() holds the console lock while it reads BUFFER. */
+        for(ret = 0; ret < len; ret += PIN_CHUNK)
+        {
+            uint32_t chunk = len - ret < PIN_CHUNK ? len - ret : PIN_CHUNK;
+            if(!pin_user_buffer(buffer + ret, chunk, false))
+                thread_exit();
+            putbuf(buffer + ret, chunk);
+            unpin_user_buffer(buffer + ret, chunk);
+        }
         ret = len;
     }
+    else if(fd_wrapper != NULL && fd_wrapper->pipe != NULL)
+    {
+        return fd_wrapper->writer ? pipe_write(fd_wrapper->pipe, buffer, len) : -1;
+    }
     else
     {
-        fd_wrapper = get_fd_wrapper_by_fd(fd);
         if(fd_wrapper != NULL)
         {
 #ifdef EFILESYS
             if(is_inode_dir(file_get_inode(fd_wrapper->file))) return -1;
 #endif
-            lock_acquire(&filesys_lock);
-            ret = file_write(fd_wrapper->file, buffer, len);
+            ret = pinned_io(fd_wrapper->file, buffer, len, -1, true,
+                            fd_wrapper->flags & O_DIRECT);
         }
     }
     return ret;
  
 }
 
+/* for sys_read */
+static int
+_read(void *args)
+{
+    int32_t fd = *(int32_t *)(args + 4);
+    void *buffer = *(void **)(args + 8);
+    uint32_t len = *(uint32_t *)(args + 12);
+    return read_fd(fd, buffer, len);
+}
+
+/* for sys_write */
+static int
+_write(void *args)
+{
+    int32_t fd = *(int32_t *)(args + 4);
+    void *buffer = *(void **)(args + 8);
+    uint32_t len = *(uint32_t *)(args + 12);
+    return write_fd(fd, buffer, len);
+}
+
+/* Returns the open file behind FD for a positional transfer, or
+   NULL if FD is the console or a pipe, is not open, or, for a
+   write, is a directory.  Descriptors 0 and 1 have no wrapper
+   while they are the console, but dup2() may have pointed them
+   at a file. */
+static struct file *
+positional_file(int32_t fd, bool write UNUSED)
+{
+    struct fd_wrap *fd_wrapper = get_fd_wrapper_by_fd(fd);
+    if(fd_wrapper == NULL || fd_wrapper->file == NULL)
+        return NULL;
+#ifdef EFILESYS
+    if(write && is_inode_dir(file_get_inode(fd_wrapper->file)))
+        return NULL;
+#endif
+    return fd_wrapper->file;
+}
+
+/* for sys_pread */
+static int
+_pread(void *args)
+{
+    int32_t fd = *(int32_t *)(args + 4);
+    void *buffer = *(void **)(args + 8);
+    uint32_t len = *(uint32_t *)(args + 12);
+    off_t offset = *(off_t *)(args + 16);
+    struct file *file;
+
+    check_user_range(buffer, len);
+    file = positional_file(fd, false);
+    if(file == NULL || offset < 0)
+        return -1;
+    return pinned_io(file, buffer, len, offset, false, false);
+}
+
+/* for sys_pwrite */
+static int
+_pwrite(void *args)
+{
+    int32_t fd = *(int32_t *)(args + 4);
+    void *buffer = *(void **)(args + 8);
+    uint32_t len = *(uint32_t *)(args + 12);
+    off_t offset = *(off_t *)(args + 16);
+    struct file *file;
+
+    check_user_range(buffer, len);
+    file = positional_file(fd, true);
+    if(file == NULL || offset < 0)
+        return -1;
+    return pinned_io(file, buffer, len, offset, true, false);
+}
+
+/* for sys_copy_file_range */
+static int
+_copy_file_range(void *args)
+{
+    int32_t fd_in = *(int32_t *)(args + 4);
+    int32_t fd_out = *(int32_t *)(args + 8);
+    int32_t len = *(int32_t *)(args + 12);
+    /* Neither end may be a directory. */
+    struct file *in = positional_file(fd_in, true);
+    struct file *out = positional_file(fd_out, true);
+
+    if(in == NULL || out == NULL || len < 0)
+        return -1;
+
+    lock_acquire(&filesys_lock);
+    /* A forward copy within one file would read back what it has
+       just written if the ranges overlap. */
+    if(file_get_inode(in) == file_get_inode(out))
+    {
+        off_t in_pos = file_tell(in);
+        off_t out_pos = file_tell(out);
+        if(in_pos < out_pos + len && out_pos < in_pos + len)
+            return -1;
+    }
+    return file_copy(out, in, len);
+}
+
+/* for sys_io_setup */
+static bool
+_io_setup(void *args)
+{
+    void *addr = *(void **)(args + 4);
+    uint32_t buf_pages = *(uint32_t *)(args + 8);
+    return ioring_setup(addr, buf_pages);
+}
+
+/* for sys_io_enter */
+static int
+_io_enter(void *args)
+{
+    uint32_t to_submit = *(uint32_t *)(args + 4);
+    uint32_t min_complete = *(uint32_t *)(args + 8);
+    return ioring_enter(to_submit, min_complete);
+}
+
+/* Must match struct iovec in lib/user/syscall.h. */
+struct iovec
+{
+    void *iov_base;
+    uint32_t iov_len;
+};
+
+/* Most buffers one readv or writev may name. */
+#define IOV_MAX 1024
+
+/* Iovecs copied in from user memory at a time. */
+#define IOV_BATCH 16
+
+/* Reads into (or, if WRITE, writes from) the IOVCNT buffers
+   described by the user iovec array UIOV, in order, at FD's
+   current position.  Stops after a short transfer.  Returns the
+   total number of bytes transferred, or -1 if IOVCNT is out of
+   range or the first transfer fails. */
+static int
+vector_io(int32_t fd, const struct iovec *uiov, int iovcnt, bool write)
+{
+    struct iovec iov[IOV_BATCH];
+    int total = 0;
+    int i, j;
+
+    if(iovcnt < 0 || iovcnt > IOV_MAX)
+        return -1;
+    for(i = 0; i < iovcnt; i += IOV_BATCH)
+    {
+        int cnt = iovcnt - i < IOV_BATCH ? iovcnt - i : IOV_BATCH;
+        if(!copy_from_user(iov, uiov + i, cnt * sizeof *iov))
+            thread_exit();
+        for(j = 0; j < cnt; j++)
+        {
+            int n = write ? write_fd(fd, iov[j].iov_base, iov[j].iov_len)
+                          : read_fd(fd, iov[j].iov_base, iov[j].iov_len);
+            if(n < 0)
+                return total > 0 ? total : n;
+            total += n;
+            if((uint32_t)n < iov[j].iov_len)
+                return total;
+        }
+    }
+    return total;
+}
+
+/* for sys_readv */
+static int
+_readv(void *args)
+{
+    int32_t fd = *(int32_t *)(args + 4);
+    const struct iovec *uiov = *(const struct iovec **)(args + 8);
+    int iovcnt = *(int *)(args + 12);
+    return vector_io(fd, uiov, iovcnt, false);
+}
+
+/* for sys_writev */
+static int
+_writev(void *args)
+{
+    int32_t fd = *(int32_t *)(args + 4);
+    const struct iovec *uiov = *(const struct iovec **)(args + 8);
+    int iovcnt = *(int *)(args + 12);
+    return vector_io(fd, uiov, iovcnt, true);
+}
+
 /* for sys_seek */
 static void
-_seek(void *esp)
+_seek(void *args)
 {
-    int32_t fd = *(int32_t *)(esp + 4);
-    unsigned position = *(unsigned *)(esp + 8);
+    int32_t fd = *(int32_t *)(args + 4);
+    unsigned position = *(unsigned *)(args + 8);
     struct fd_wrap *fd_wrapper;
     fd_wrapper = get_fd_wrapper_by_fd(fd);
-    if(fd_wrapper != NULL)
+    if(fd_wrapper != NULL && fd_wrapper->file != NULL)
     {
         lock_acquire(&filesys_lock);
         file_seek(fd_wrapper->file, position);
@@ -329,12 +853,12 @@ _seek(void *esp)
 
 /* for sys_tell */
 static unsigned
-_tell(void *esp)
+_tell(void *args)
 {
-    int32_t fd = *(int32_t *)(esp + 4);
+    int32_t fd = *(int32_t *)(args + 4);
     struct fd_wrap *fd_wrapper;
     fd_wrapper = get_fd_wrapper_by_fd(fd);
-    if(fd_wrapper != NULL)
+    if(fd_wrapper != NULL && fd_wrapper->file != NULL)
     {
         lock_acquire(&filesys_lock);
         return file_tell(fd_wrapper->file);
@@ -389,10 +913,10 @@ allocate_mapid(void)
 
 
 static Mapid_t 
-_mmap(void *esp)
+_mmap(void *args)
 {
-    int32_t fd = *(int32_t *)(esp + 4);
-    void *addr = *(void **)(esp + 8);
+    int32_t fd = *(int32_t *)(args + 4);
+    void *addr = *(void **)(args + 8);
     struct thread *t = thread_current();
     struct fd_wrap *fd_wrapper = NULL;
     struct mmap_wrap *mmap_wrapper = NULL;
@@ -420,7 +944,8 @@ _mmap(void *esp)
           }
       }
 
-      uint32_t read_bytes = file_length(fd_wrapper->file);
+      uint32_t read_bytes = (fd_wrapper != NULL && fd_wrapper->file != NULL)
+                            ? file_length(fd_wrapper->file) : 0;
       if(read_bytes == 0)
         mapid = -1;
 
@@ -467,9 +992,9 @@ _mmap(void *esp)
 }
 
 static void
-_unmap(void *esp)
+_unmap(void *args)
 {
-    Mapid_t mapping = *(Mapid_t *)(esp + 4);
+    Mapid_t mapping = *(Mapid_t *)(args + 4);
     struct mmap_wrap *mmap_wrapper = get_map_wrapper_by_mapid(mapping);
     struct SPT_elem *elem;
 
@@ -485,14 +1010,43 @@ _unmap(void *esp)
         free(mmap_wrapper);
     }
 }
+
+static bool
+_shm_create(void *args)
+{
+    const char *uname = *(const char **)(args + 4);
+    size_t size = *(size_t *)(args + 8);
+    char name[SHM_NAME_MAX + 1];
+    if(!get_user_string(name, uname, sizeof name)) return false;
+    return shm_create(name, size);
+}
+
+static bool
+_shm_attach(void *args)
+{
+    const char *uname = *(const char **)(args + 4);
+    void *addr = *(void **)(args + 8);
+    char name[SHM_NAME_MAX + 1];
+    if(!get_user_string(name, uname, sizeof name)) return false;
+    return shm_attach(name, addr);
+}
+
+static bool
+_shm_detach(void *args)
+{
+    void *addr = *(void **)(args + 4);
+    return shm_detach(addr);
+}
 #endif
 #ifdef EFILESYS
 static bool
-_chdir(void *esp)
+_chdir(void *args)
 {
-    const char *dir = *(const char **)(esp + 4);
+    const char *udir = *(const char **)(args + 4);
+    char path[0x100];
+    char *dir = path;
     struct dir *start = NULL;
-    if(dir == NULL) return false;
+    if(!get_user_string(path, udir, sizeof path)) return false;
     // create inode for directory
 
     if(dir[0] == '/')
@@ -504,20 +1058,19 @@ _chdir(void *esp)
     {
         start = dir_reopen(thread_current()->CWD);
     }
-    char *_dir = malloc(strlen(dir) + 1);
-    strlcpy(_dir, dir, strlen(dir) + 1);
-    bool success = dir_change(_dir, start);
-    free(_dir);
+    bool success = dir_change(dir, start);
     dir_close(start);
     return success;
 }
 
 static bool
-_mkdir(void *esp)
+_mkdir(void *args)
 {
-    const char *dir = *(const char **)(esp + 4);
+    const char *udir = *(const char **)(args + 4);
+    char path[0x100];
+    char *dir = path;
     struct dir *start = NULL;
-    if(dir == NULL) return false;
+    if(!get_user_string(path, udir, sizeof path)) return false;
     // create inode for directory
 
     if(dir[0] == '/')
@@ -529,30 +1082,64 @@ _mkdir(void *esp)
     {
         start = dir_reopen(thread_current()->CWD);
     }
-    char *_dir = malloc(strlen(dir) + 1);
-    strlcpy(_dir, dir, strlen(dir) + 1);
-    bool success = dir_make(_dir, start);
-    free(_dir);
+    bool success = dir_make(dir, start);
     dir_close(start);
     return success;
 }
 
 static bool
-_readdir(void *esp)
+_readdir(void *args)
 {
-    int fd = *(int *)(esp + 4);
-    char *name = *(char **)(esp + 8);
+    int fd = *(int *)(args + 4);
+    char *uname = *(char **)(args + 8);
+    char name[NAME_MAX + 1];
     struct fd_wrap *fd_wrapper;
     lock_acquire(&filesys_lock);
     fd_wrapper = get_fd_wrapper_by_fd(fd);
     bool success = fd_wrapper != NULL && fd_wrapper->dir != NULL && dir_readdir(fd_wrapper->dir, name);
+    if(success && !copy_to_user(uname, name, strlen(name) + 1))
+        thread_exit();
     return success;
 }
 
+/* Records copied out to user memory at a time by getdents. */
+#define DIRENT_BATCH 8
+
+/* for sys_getdents */
+static int
+_getdents(void *args)
+{
+    int fd = *(int *)(args + 4);
+    struct dir_record *ubuf = *(struct dir_record **)(args + 8);
+    int cnt = *(int *)(args + 12);
+    struct dir_record records[DIRENT_BATCH];
+    struct fd_wrap *fd_wrapper;
+    int total = 0;
+
+    if(cnt < 0 || (size_t)cnt > SIZE_MAX / sizeof *ubuf)
+        return -1;
+    check_user_range(ubuf, cnt * sizeof *ubuf);
+    lock_acquire(&filesys_lock);
+    fd_wrapper = get_fd_wrapper_by_fd(fd);
+    if(fd_wrapper == NULL || fd_wrapper->dir == NULL)
+        return -1;
+    while(total < cnt)
+    {
+        size_t want = cnt - total < DIRENT_BATCH ? cnt - total : DIRENT_BATCH;
+        size_t n = dir_read_entries(fd_wrapper->dir, records, want);
+        if(!copy_to_user(ubuf + total, records, n * sizeof *records))
+            thread_exit();
+        total += n;
+        if(n < want)
+            break;
+    }
+    return total;
+}
+
 static bool
-_is_dir(void *esp)
+_is_dir(void *args)
 {
-    int fd = *(int *)(esp + 4);
+    int fd = *(int *)(args + 4);
     struct fd_wrap *fd_wrapper;
     lock_acquire(&filesys_lock);
     fd_wrapper = get_fd_wrapper_by_fd(fd);
@@ -560,14 +1147,14 @@ _is_dir(void *esp)
 }
 
 static int
-_inumber(void *esp)
+_inumber(void *args)
 {
-    int fd = *(int *)(esp + 4);
+    int fd = *(int *)(args + 4);
     struct fd_wrap *fd_wrapper;
     struct file *file;
     lock_acquire(&filesys_lock);
     fd_wrapper = get_fd_wrapper_by_fd(fd);
-    if(fd_wrapper == NULL) return -1;
+    if(fd_wrapper == NULL || fd_wrapper->file == NULL) return -1;
     file = fd_wrapper->file;
     return inode_get_inumber(file_get_inode(file));
 }
@@ -575,102 +1162,175 @@ _inumber(void *esp)
 static void
 syscall_handler (struct intr_frame *f UNUSED) 
 {
+  uint32_t args[5];     /* Syscall number and up to 4 arguments. */
   uint32_t sysnum;
 
-  sysnum = *(uint32_t *)f->esp;
   thread_current()->syscall_esp = f->esp;
-  thread_current()->is_syscall = true;
+  check_args(f->esp, args, 1);
+  sysnum = args[0];
   switch(sysnum)
   {
     case SYS_HALT:
-        check_args(f->esp, 1);
+        check_args(f->esp, args, 1);
         _halt();
         break;
     case SYS_EXIT:
-        check_args(f->esp, 2);
-        _exit(f->esp);
+        check_args(f->esp, args, 2);
+        _exit(args);
         break;
     case SYS_EXEC:
-        check_args(f->esp, 2);
-        f->eax = _exec(f->esp);
+        check_args(f->esp, args, 2);
+        f->eax = _exec(args);
         break;
     case SYS_WAIT:
-        check_args(f->esp, 2);
-        f->eax = _wait(f->esp);
+        check_args(f->esp, args, 2);
+        f->eax = _wait(args);
         break;
     case SYS_CREATE:
-        check_args(f->esp, 3);
-        f->eax = _create(f->esp);
+        check_args(f->esp, args, 3);
+        f->eax = _create(args);
         break;
     case SYS_REMOVE:
-        check_args(f->esp, 2);
-        f->eax = _remove(f->esp);
+        check_args(f->esp, args, 2);
+        f->eax = _remove(args);
         break;
     case SYS_OPEN:
-        check_args(f->esp, 2);
-        f->eax = _open(f->esp);
+        check_args(f->esp, args, 2);
+        f->eax = _open(args);
         break;
     case SYS_FILESIZE:
-        check_args(f->esp, 2);
-        f->eax = _file_size(f->esp);
+        check_args(f->esp, args, 2);
+        f->eax = _file_size(args);
         break;
     case SYS_READ:
-        check_args(f->esp, 4);
-        f->eax = _read(f->esp);
+        check_args(f->esp, args, 4);
+        f->eax = _read(args);
         break;
     case SYS_WRITE:
-        check_args(f->esp, 4);
-        f->eax = _write(f->esp);
+        check_args(f->esp, args, 4);
+        f->eax = _write(args);
         break;
     case SYS_SEEK:
-        check_args(f->esp, 3);
-        _seek(f->esp);
+        check_args(f->esp, args, 3);
+        _seek(args);
         break;
     case SYS_TELL:
-        check_args(f->esp, 2);
-        f->eax = _tell(f->esp);
+        check_args(f->esp, args, 2);
+        f->eax = _tell(args);
         break;
     case SYS_CLOSE:
-        check_args(f->esp, 2);
-        _close(f->esp);
+        check_args(f->esp, args, 2);
+        _close(args);
         break;
 #ifdef VM
     case SYS_MMAP:
-        check_args(f->esp, 3);
-        f->eax = _mmap(f->esp);
+        check_args(f->esp, args, 3);
+        f->eax = _mmap(args);
         break;
     case SYS_MUNMAP:
-        check_args(f->esp, 2);
-        _unmap(f->esp);
+        check_args(f->esp, args, 2);
+        _unmap(args);
+        break;
+    case SYS_SHM_CREATE:
+        check_args(f->esp, args, 3);
+        f->eax = _shm_create(args);
+        break;
+    case SYS_SHM_ATTACH:
+        check_args(f->esp, args, 3);
+        f->eax = _shm_attach(args);
+        break;
+    case SYS_SHM_DETACH:
+        check_args(f->esp, args, 2);
+        f->eax = _shm_detach(args);
+        break;
+    case SYS_FORK:
+        check_args(f->esp, args, 1);
+        f->eax = process_fork(f);
         break;
 #endif
 #ifdef EFILESYS
     case SYS_CHDIR:
-        check_args(f->esp, 2);
-        f->eax = _chdir(f->esp);
+        check_args(f->esp, args, 2);
+        f->eax = _chdir(args);
         break;
     case SYS_MKDIR:
-        check_args(f->esp, 2);
-        f->eax = _mkdir(f->esp);
+        check_args(f->esp, args, 2);
+        f->eax = _mkdir(args);
         break;
     case SYS_READDIR:
-        check_args(f->esp, 3);
-        f->eax = _readdir(f->esp);
+        check_args(f->esp, args, 3);
+        f->eax = _readdir(args);
+        break;
+    case SYS_GETDENTS:
+        check_args(f->esp, args, 4);
+        f->eax = _getdents(args);
         break;
     case SYS_ISDIR:
-        check_args(f->esp, 2);
-        f->eax = _is_dir(f->esp);
+        check_args(f->esp, args, 2);
+        f->eax = _is_dir(args);
         break;
     case SYS_INUMBER:
-        check_args(f->esp, 2);
-        f->eax = _inumber(f->esp);
+        check_args(f->esp, args, 2);
+        f->eax = _inumber(args);
         break;
 #endif
+    case SYS_OPEN_FLAGS:
+        check_args(f->esp, args, 3);
+        f->eax = _open_flags(args);
+        break;
+    case SYS_PREAD:
+        check_args(f->esp, args, 5);
+        f->eax = _pread(args);
+        break;
+    case SYS_PWRITE:
+        check_args(f->esp, args, 5);
+        f->eax = _pwrite(args);
+        break;
+    case SYS_READV:
+        check_args(f->esp, args, 4);
+        f->eax = _readv(args);
+        break;
+    case SYS_WRITEV:
+        check_args(f->esp, args, 4);
+        f->eax = _writev(args);
+        break;
+    case SYS_COPY_FILE_RANGE:
+        check_args(f->esp, args, 4);
+        f->eax = _copy_file_range(args);
+        break;
+    case SYS_IO_SETUP:
+        check_args(f->esp, args, 3);
+        f->eax = _io_setup(args);
+        break;
+    case SYS_IO_ENTER:
+        check_args(f->esp, args, 3);
+        f->eax = _io_enter(args);
+        break;
+    case SYS_PIPE:
+        check_args(f->esp, args, 2);
+        f->eax = _pipe(args);
+        break;
+    case SYS_DUP2:
+        check_args(f->esp, args, 3);
+        f->eax = _dup2(args);
+        break;
+    case SYS_SPLICE:
+        check_args(f->esp, args, 4);
+        f->eax = _splice(args);
+        break;
+    case SYS_NANOTIME:
+    {
+        /* 64-bit result in edx:eax. */
+        check_args(f->esp, args, 1);
+        uint64_t ns = timer_nanos();
+        f->eax = (uint32_t)ns;
+        f->edx = (uint32_t)(ns >> 32);
+        break;
+    }
     default:
         PANIC("NOT HANDLED");
   }
   if(lock_held_by_current_thread(&filesys_lock))
       lock_release(&filesys_lock);
-  thread_current()->is_syscall = false;
   //printf("SYSCALL BY %s : ret: %x\n", thread_current()->name, f->eax);
 }
@@ -1,8 +1,17 @@
+#include <stdint.h>
 #include "threads/synch.h"
+#include "threads/slab.h"
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+struct fd_wrap;
+struct thread;
+
 struct lock filesys_lock;
+extern struct slab_cache fd_cache;      /* struct fd_wrap. */
 void syscall_init (void);
+struct fd_wrap *get_fd_wrapper_by_fd (int32_t fd);
+void fd_free (struct fd_wrap *);
+void inherit_fds (struct thread *parent);
 
 #endif /* userprog/syscall.h */
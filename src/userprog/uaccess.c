@@ -0,0 +1,119 @@
+#include "userprog/uaccess.h"
+#include <debug.h>
+#include "threads/vaddr.h"
+
+/* Exception table bounds, defined by the linker script.  See
+   kernel.lds.S. */
+extern const struct exception_entry __start_ex_table[], __stop_ex_table[];
+
+/* Emits an exception table entry directing a fault at label
+   FROM to label TO.  For use inside asm statements. */
+#define EX_TABLE(FROM, TO)                      \
+        ".section __ex_table, \"a\"\n\t"        \
+        ".long " #FROM ", " #TO "\n\t"          \
+        ".previous\n\t"
+
+/* Returns true if the SIZE bytes at UADDR lie entirely in user
+   virtual memory. */
+bool
+is_user_range (const void *uaddr, size_t size)
+{
+  uintptr_t start = (uintptr_t) uaddr;
+
+  return start + size >= start && start + size <= (uintptr_t) PHYS_BASE;
+}
+
+/* Copies SIZE bytes from SRC to DST, either of which may be in
+   user memory, a word at a time and then a byte at a time.
+   Returns true if successful, false if an access faulted. */
+static bool
+user_copy (void *dst, const void *src, size_t size)
+{
+  size_t words = size / 4;
+
+  /* Whichever rep instruction faults leaves a nonzero count in
+     ECX, so checking ECX afterward tells success from failure. */
+  asm volatile ("1: rep movsl\n\t"
+                "movl %3, %%ecx\n\t"
+                "2: rep movsb\n\t"
+                "3:\n\t"
+                EX_TABLE (1b, 3b)
+                EX_TABLE (2b, 3b)
+                : "+D" (dst), "+S" (src), "+c" (words)
+                : "r" (size % 4)
+                : "memory");
+  return words == 0;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.  Returns true if successful, false if any part of USRC is
+   not mapped user memory. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size)
+{
+  return is_user_range (usrc, size) && user_copy (dst, usrc, size);
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+   UDST.  Returns true if successful, false if any part of UDST
+   is not mapped, writable user memory. */
+bool
+copy_to_user (void *udst, const void *src, size_t size)
+{
+  return is_user_range (udst, size) && user_copy (udst, src, size);
+}
+
+/* Reads a byte at user virtual address UADDR, which must be
+   below PHYS_BASE.  Returns the byte value if successful, -1 if
+   a page fault occurred. */
+static inline int
+get_user (const uint8_t *uaddr)
+{
+  int result;
+
+  asm ("movl $-1, %0\n\t"
+       "1: movzbl %1, %0\n\t"
+       "2:\n\t"
+       EX_TABLE (1b, 2b)
+       : "=&r" (result) : "m" (*uaddr));
+  return result;
+}
+
+/* Copies the null-terminated string at user address USRC into
+   DST, which has room for SIZE bytes.  Returns the length of the
+   string, not counting the null terminator, if it fits.  Returns
+   SIZE if it does not fit, in which case DST is not terminated.
+   Returns -1 if USRC is not mapped user memory. */
+int
+strncpy_from_user (char *dst, const char *usrc, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    {
+      int c;
+
+      if (!is_user_vaddr (usrc + i))
+        return -1;
+      c = get_user ((const uint8_t *) usrc + i);
+      if (c < 0)
+        return -1;
+      dst[i] = c;
+      if (c == '\0')
+        return i;
+    }
+  return size;
+}
+
+/* Returns the fixup address for a kernel page fault at EIP, or 0
+   if EIP is not an instruction that accesses user memory. */
+uintptr_t
+search_exception_table (uintptr_t eip)
+{
+  const struct exception_entry *e;
+
+  for (e = __start_ex_table; e < __stop_ex_table; e++)
+    if (e->insn == eip)
+      return e->fixup;
+  return 0;
+}
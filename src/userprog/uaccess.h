@@ -0,0 +1,31 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Access to user memory from the kernel.
+
+   These functions touch user memory directly, so that a valid
+   buffer is copied at memcpy() speed with no page table walk.
+   An access that faults is recovered by page_fault() through
+   the exception table below, and the function reports failure
+   instead of the fault killing whatever kernel path made it. */
+
+bool is_user_range (const void *uaddr, size_t size);
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+int strncpy_from_user (char *dst, const char *usrc, size_t size);
+
+/* An exception table entry.  A kernel-mode page fault at INSN
+   resumes at FIXUP. */
+struct exception_entry
+  {
+    uintptr_t insn;             /* Address of a faulting instruction. */
+    uintptr_t fixup;            /* Where to continue after a fault. */
+  };
+
+uintptr_t search_exception_table (uintptr_t eip);
+
+#endif /* userprog/uaccess.h */
@@ -0,0 +1,235 @@
+#include "vm/cow.h"
+#include <debug.h>
+#include <hash.h>
+#include <string.h>
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/shm.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+
+/* Copy-on-write sharing after fork().
+
+   fork() turns every page of the parent that has a frame, in
+   memory or swapped out, into a shared page (see vm/shm.c) that
+   the parent and child both map read-only through VM_COW
+   entries.  Pages never brought in are simply given to the child
+   as well, to be loaded on their own when touched.
+
+   A write to a VM_COW page faults.  cow_fault() then gives the
+   writer a private copy, or, if no other process still shares
+   the page, hands it the shared frame itself without copying.
+   Either way the writer's entry becomes an ordinary anonymous
+   VM_STACK page.
+
+   All of this state is protected by page_lock. */
+
+/* A page shared copy-on-write. */
+struct cow_page
+  {
+    struct shm_page page;       /* Must be first. */
+    int ref_cnt;                /* VM_COW entries mapping it. */
+    bool writable;              /* Writable in the original mapping? */
+  };
+
+/* Returns the copy-on-write page behind VM_COW entry ELEM. */
+static struct cow_page *
+cow_page_of(struct SPT_elem *elem)
+{
+  struct shm_map *map = elem->aux;
+  ASSERT(elem->type == VM_COW);
+  return (struct cow_page *)map->page;
+}
+
+/* Converts ELEM, a VM_STACK or VM_SEGMENT entry of PARENT that
+   has a frame, into a VM_COW entry for a new copy-on-write page
+   that takes over the frame.  If the page is mapped, it stays
+   mapped, read-only.  Returns false if memory is short. */
+static bool
+cow_share(struct SPT_elem *elem, struct thread *parent)
+{
+  struct cow_page *cp = malloc(sizeof *cp);
+  struct shm_map *map = malloc(sizeof *map);
+  struct FRAME_elem *frame = elem->frame_ptr;
+
+  ASSERT(frame != NULL);
+  if(cp == NULL || map == NULL)
+  {
+      free(cp);
+      free(map);
+      return false;
+  }
+
+  shm_page_init(&cp->page);
+  cp->ref_cnt = 1;
+  cp->writable = elem->type == VM_SEGMENT ? (bool)((int32_t *)elem->aux)[2] : true;
+  cp->page.spt.paddr = elem->paddr;
+  cp->page.spt.frame_ptr = frame;
+  frame->SPT_ptr = &cp->page.spt;
+  frame->holder = NULL;
+
+  free(elem->aux);
+  elem->type = VM_COW;
+  elem->aux = map;
+  elem->frame_ptr = NULL;
+  map->page = &cp->page;
+  map->owner = parent;
+  map->writable = false;
+  map->mapped = false;
+  if(elem->paddr != NULL)
+  {
+      pagedir_set_writable(parent->pagedir, elem->vaddr, false);
+      list_push_back(&cp->page.mappers, &elem->mmap_elem);
+      map->mapped = true;
+  }
+  return true;
+}
+
+/* Gives the current process a VM_COW entry at UPAGE for CP,
+   mapping it at once if it is in memory. */
+static bool
+cow_map(void *upage, struct cow_page *cp)
+{
+  struct shm_map *map = malloc(sizeof *map);
+  if(map == NULL || !palloc_user_page(upage, VM_COW, map))
+  {
+      free(map);
+      return false;
+  }
+  map->page = &cp->page;
+  map->owner = thread_current();
+  map->writable = false;
+  map->mapped = false;
+  cp->ref_cnt++;
+  if(cp->page.spt.paddr != NULL)
+    shm_install(vm_lookup_page(upage));
+  return true;
+}
+
+/* Gives the current process, a child just forked from PARENT,
+   a copy-on-write copy of the page PARENT has in ELEM.  Segment
+   pages not yet loaded are loaded from EXECUTABLE, the child's
+   own handle on PARENT's executable. */
+static bool
+cow_clone(struct SPT_elem *elem, struct thread *parent, struct file *executable)
+{
+  void **args;
+
+  switch(elem->type)
+  {
+    case VM_STACK:
+    case VM_SEGMENT:
+      if(elem->frame_ptr != NULL)
+      {
+          if(!cow_share(elem, parent))
+            return false;
+          return cow_map(elem->vaddr, cow_page_of(elem));
+      }
+      if(elem->type == VM_STACK)
+        return palloc_user_page(elem->vaddr, VM_STACK, NULL);
+      args = malloc(sizeof(void *) * 4);
+      if(args == NULL)
+        return false;
+      memcpy(args, elem->aux, sizeof(void *) * 4);
+      args[0] = executable;
+      if(!palloc_user_page(elem->vaddr, VM_SEGMENT, args))
+      {
+          free(args);
+          return false;
+      }
+      return true;
+    case VM_COW:
+      return cow_map(elem->vaddr, cow_page_of(elem));
+    default:
+      /* Mapped files are not inherited; shared memory is
+         reattached by shm_fork(). */
+      return true;
+  }
+}
+
+/* Copies PARENT's address space into the current process, which
+   PARENT has just forked, sharing every page PARENT has brought
+   in copy-on-write.  PARENT must be blocked until this returns.
+   Returns false if memory is short. */
+bool
+cow_fork(struct thread *parent, struct file *executable)
+{
+  struct hash_iterator iter;
+  bool success = true;
+
+  lock_acquire(&page_lock);
+  hash_first(&iter, &parent->SPT);
+  while(success && hash_next(&iter))
+  {
+      struct SPT_elem *elem = hash_entry(hash_cur(&iter), struct SPT_elem, elem);
+      success = cow_clone(elem, parent, executable);
+  }
+  lock_release(&page_lock);
+  return success;
+}
+
+/* Handles a write fault on ELEM, a VM_COW entry of the current
+   process, by giving it a private, writable page.  Returns false
+   if the page was never writable.  page_lock must be held. */
+bool
+cow_fault(struct SPT_elem *elem)
+{
+  struct cow_page *cp = cow_page_of(elem);
+  struct SPT_elem *shared = &cp->page.spt;
+
+  if(!cp->writable)
+    return false;
+  if(cp->ref_cnt > 1 && shared->paddr == NULL && !vm_install(shared))
+    return false;
+
+  shm_unmap(elem);
+  free(elem->aux);
+  elem->type = VM_STACK;
+  elem->aux = NULL;
+
+  if(cp->ref_cnt == 1)
+  {
+      /* Last user: take the frame over as it is. */
+      elem->frame_ptr = shared->frame_ptr;
+      elem->frame_ptr->SPT_ptr = elem;
+      elem->frame_ptr->holder = thread_current();
+      elem->paddr = shared->paddr;
+      free(cp);
+      if(elem->paddr == NULL)
+        return vm_install(elem);
+      return vm_install_page(elem, true);
+  }
+  else
+  {
+      bool success;
+
+      cp->ref_cnt--;
+
+      /* Keep the original in memory while a frame is found for
+         the copy. */
+      shared->frame_ptr->pin_cnt++;
+      success = vm_install(elem);
+      if(success)
+        memcpy(elem->paddr, shared->paddr, PGSIZE);
+      shared->frame_ptr->pin_cnt--;
+      return success;
+  }
+}
+
+/* Drops ELEM's reference to its copy-on-write page, before
+   frame_destroy() discards it, freeing the page with the last
+   reference.  page_lock must be held. */
+void
+cow_release(struct SPT_elem *elem)
+{
+  struct cow_page *cp = cow_page_of(elem);
+
+  shm_unmap(elem);
+  if(--cp->ref_cnt == 0)
+  {
+      shm_page_free(&cp->page);
+      free(cp);
+  }
+}
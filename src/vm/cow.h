@@ -0,0 +1,12 @@
+#ifndef COW_H
+#define COW_H
+#include <stdbool.h>
+
+struct SPT_elem;
+struct thread;
+struct file;
+
+bool cow_fork(struct thread *parent, struct file *executable);
+bool cow_fault(struct SPT_elem *);
+void cow_release(struct SPT_elem *);
+#endif /* vm/cow.h */
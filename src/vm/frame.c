@@ -2,6 +2,8 @@
 #include "vm/frame.h"
 #include "vm/swap.h"
 #include "vm/page.h"
+#include "vm/shm.h"
+#include "vm/cow.h"
 #include "threads/vaddr.h"
 #include "threads/thread.h"
 #include "threads/malloc.h"
@@ -12,9 +14,15 @@
 
 void frame_destroy(struct SPT_elem *elem)
 {
-  if(elem->frame_ptr && elem->frame_ptr->swaped == DISK)
+  /* The frame behind a shared page belongs to its segment. */
+  if(elem->type == VM_SHM)
+    shm_unmap(elem);
+  else if(elem->type == VM_COW)
+    cow_release(elem);
+
+  if(elem->frame_ptr)
     {
-        bitmap_set_multiple(free_space, elem->frame_ptr->start, 1, false);
+        swap_release(elem->frame_ptr);
     }
 
     if(elem->paddr)
@@ -36,9 +44,9 @@ void frame_destroy(struct SPT_elem *elem)
     if(elem->frame_ptr)
     {
         list_remove(&(elem->frame_ptr->elem));
-        free(elem->frame_ptr);
+        slab_free(&frame_cache, elem->frame_ptr);
     }
-    free(elem);
+    slab_free(&spt_cache, elem);
 }
 
 void write_back(struct SPT_elem *elem)
@@ -10,9 +10,12 @@ struct FRAME_elem
     struct SPT_elem *SPT_ptr;
     struct thread *holder;
     swap_state swaped;
+    int pin_cnt;            /* pins by I/O in progress; never evicted while > 0 */
     struct list_elem elem;
 
-    disk_sector_t start;
+    disk_sector_t start;    /* swap slot, or first zswap chunk */
+    size_t zlen;            /* compressed bytes in zswap, 0 if same-filled */
+    uint32_t zfill;         /* fill word of a same-filled zswap page */
 };
 
 typedef uint32_t Mapid_t;
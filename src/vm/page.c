@@ -9,11 +9,17 @@
 #include "threads/palloc.h"
 #include "threads/vaddr.h"
 #include "userprog/pagedir.h"
+#include "userprog/uaccess.h"
 #include "filesys/file.h"
+#include "vm/cow.h"
 #include "vm/frame.h"
 #include "vm/swap.h"
 #include "vm/page.h"
+#include "vm/shm.h"
 #include "devices/disk.h"
+struct slab_cache spt_cache;
+struct slab_cache frame_cache;
+
 static bool vm_install_stack(struct SPT_elem *);
 static bool vm_install_segment(struct SPT_elem *);
 
@@ -22,8 +28,10 @@ void vm_init()
   list_init(&FT);
   list_init(&swap_list);
   lock_init(&page_lock);
-  swap_disk = disk_get(1,1); // swap disk
-  free_space = bitmap_create(disk_size(swap_disk) >> 3);
+  slab_cache_init(&spt_cache, "spt", sizeof(struct SPT_elem), 0);
+  slab_cache_init(&frame_cache, "frame", sizeof(struct FRAME_elem), 0);
+  swap_init();
+  shm_init();
 }
 
 unsigned page_hash_func(const struct hash_elem *e, void *aux)
@@ -46,7 +54,7 @@ bool palloc_user_page(void *upage, vm_type type, void *aux)
     struct thread *t = thread_current();
     bool success = false;
     ASSERT(upage != NULL);
-    struct SPT_elem *SPT_elem = (struct SPT_elem *)malloc(sizeof(struct SPT_elem));
+    struct SPT_elem *SPT_elem = slab_alloc(&spt_cache);
     if(SPT_elem != NULL)
     {
       success = true;
@@ -116,6 +124,17 @@ vm_install_segment(struct SPT_elem *elem)
     return success;
 }
 
+/* Brings in VM_SHM_PAGE ELEM, the zero-filled page of a shared
+   memory segment.  It has no mapping of its own: shm_install()
+   maps it into the processes that share it. */
+static bool
+vm_install_shm_page(struct SPT_elem *elem)
+{
+    ASSERT(elem->type == VM_SHM_PAGE);
+    elem->paddr = palloc_get_page(PAL_USER | PAL_ZERO);
+    return (elem->paddr == NULL) ? swap_out(elem) : true;
+}
+
 static bool
 vm_install_mmap(struct SPT_elem *elem)
 {
@@ -148,6 +167,8 @@ vm_install(struct SPT_elem *elem)
 {
   bool success = false;
   ASSERT(elem->paddr == NULL);
+  if(elem->type == VM_SHM || elem->type == VM_COW)
+    return shm_install(elem);
   if(!elem->frame_ptr)
   {
     // no frame allocated.
@@ -163,15 +184,20 @@ vm_install(struct SPT_elem *elem)
     {
         success = vm_install_mmap(elem);
     }
+    else if(elem->type == VM_SHM_PAGE)
+    {
+        success = vm_install_shm_page(elem);
+    }
 
     // double insertion due to recursion.
     if(elem->frame_ptr == NULL)
     {
-      struct FRAME_elem *FRAME_elem = (struct FRAME_elem *)malloc(sizeof(struct FRAME_elem));
+      struct FRAME_elem *FRAME_elem = slab_alloc(&frame_cache);
 
       FRAME_elem->SPT_ptr = elem;
-      FRAME_elem->holder = thread_current();
+      FRAME_elem->holder = elem->type == VM_SHM_PAGE ? NULL : thread_current();
       FRAME_elem->swaped = MEMORY;
+      FRAME_elem->pin_cnt = 0;
 
       elem->frame_ptr = FRAME_elem;
       ASSERT(elem->paddr != NULL);
@@ -192,7 +218,121 @@ vm_install(struct SPT_elem *elem)
         }
     }
   }
-  ASSERT(pagedir_get_page(elem->frame_ptr->holder->pagedir, elem->vaddr));
+  ASSERT(elem->type == VM_SHM_PAGE
+         || pagedir_get_page(elem->frame_ptr->holder->pagedir, elem->vaddr));
   //printf("install %x to %x of %d\n", elem->vaddr, elem->paddr, elem->frame_ptr->holder->tid);
   return success;
 }
+
+/* Returns the supplemental page table entry for user page UPAGE
+   of the current process, or NULL if it has none. */
+struct SPT_elem *
+vm_lookup_page(void *upage)
+{
+  struct SPT_elem key;
+  struct hash_elem *e;
+
+  key.vaddr = upage;
+  e = hash_find(&thread_current()->SPT, &key.elem);
+  return e != NULL ? hash_entry(e, struct SPT_elem, elem) : NULL;
+}
+
+/* Returns the frame that holds user page UPAGE of the current
+   process if it is resident, otherwise NULL.  page_lock must be
+   held. */
+static struct FRAME_elem *
+resident_frame(void *upage)
+{
+  struct SPT_elem *elem = vm_lookup_page(upage);
+  if(elem != NULL && (elem->type == VM_SHM || elem->type == VM_COW)
+     && elem->paddr != NULL)
+    elem = shm_backing(elem);
+  if(elem == NULL || elem->paddr == NULL)
+    return NULL;
+  return elem->frame_ptr;
+}
+
+/* Faults in the user pages spanning SIZE bytes at UADDR and pins
+   them, so that swap_out() leaves them alone while a device
+   transfers to or from them.  If WRITE, the pages must also be
+   writable, and copy-on-write pages get private copies.  Returns
+   false, with nothing pinned, if any page is not valid user
+   memory. */
+bool
+vm_pin_range(void *uaddr, size_t size, bool write)
+{
+  uint32_t *pd = thread_current()->pagedir;
+  uint8_t *start = uaddr;
+  uint8_t *end = start + size;
+  uint8_t *upage;
+
+  for(upage = pg_round_down(start); upage < end; upage += PGSIZE)
+  {
+      uint8_t *p = upage < start ? start : upage;
+      struct FRAME_elem *frame = NULL;
+
+      /* The page may be evicted again between the touch and
+         taking page_lock, so repeat until it is seen resident. */
+      while(frame == NULL)
+      {
+          struct SPT_elem *elem;
+          uint8_t c;
+
+          /* Only read: storing even the byte just read could undo
+             a write another process made to a shared page. */
+          if(!copy_from_user(&c, p, 1))
+            goto fail;
+          lock_acquire(&page_lock);
+          if(pagedir_get_page(pd, upage) == NULL)
+          {
+              lock_release(&page_lock);
+              continue;
+          }
+          elem = vm_lookup_page(upage);
+          if(write && !pagedir_is_writable(pd, upage)
+             && (elem == NULL || elem->type != VM_COW || !cow_fault(elem)))
+          {
+              lock_release(&page_lock);
+              goto fail;
+          }
+          frame = resident_frame(upage);
+          if(frame != NULL)
+            frame->pin_cnt++;
+          lock_release(&page_lock);
+
+          /* Mapped with no supplemental entry, like an I/O ring's
+             pages: never evicted, nothing to pin. */
+          if(elem == NULL)
+            break;
+      }
+  }
+  return true;
+
+ fail:
+  if(upage > start)
+    vm_unpin_range(start, upage - start);
+  return false;
+}
+
+/* Unpins the user pages spanning SIZE bytes at UADDR, which were
+   pinned with vm_pin_range(). */
+void
+vm_unpin_range(void *uaddr, size_t size)
+{
+  uint8_t *start = uaddr;
+  uint8_t *upage;
+
+  if(size == 0)
+    return;
+  lock_acquire(&page_lock);
+  for(upage = pg_round_down(start); upage < start + size; upage += PGSIZE)
+  {
+      struct FRAME_elem *frame = resident_frame(upage);
+      if(frame != NULL)
+      {
+          ASSERT(frame->pin_cnt > 0);
+          frame->pin_cnt--;
+      }
+  }
+  lock_release(&page_lock);
+}
@@ -2,8 +2,12 @@
 #define PAGE_H
 #include <hash.h>
 #include "vm/swap.h"
+#include "threads/slab.h"
 
-typedef enum {VM_STACK, VM_SEGMENT, VM_MMAP} vm_type;
+/* VM_SHM is a process's mapping of a shared memory page and
+   VM_COW its mapping of a page shared copy-on-write; VM_SHM_PAGE
+   is the shared page itself, which belongs to no process. */
+typedef enum {VM_STACK, VM_SEGMENT, VM_MMAP, VM_SHM, VM_SHM_PAGE, VM_COW} vm_type;
 struct SPT_elem
 {
   void *vaddr;
@@ -16,6 +20,8 @@ struct SPT_elem
 };
 
 struct lock page_lock;
+extern struct slab_cache spt_cache;     /* struct SPT_elem. */
+extern struct slab_cache frame_cache;   /* struct FRAME_elem. */
 void vm_init(void);
 unsigned page_hash_func(const struct hash_elem *, void *);
 bool page_less_func(const struct hash_elem *, const struct hash_elem *, void *);
@@ -24,4 +30,7 @@ bool palloc_user_page(void *, vm_type, void *);
 bool palloc_free_user_page(void *);
 bool vm_install(struct SPT_elem *);
 bool vm_install_page(struct SPT_elem *, bool);
+struct SPT_elem *vm_lookup_page(void *);
+bool vm_pin_range(void *, size_t, bool);
+void vm_unpin_range(void *, size_t);
 #endif /* vm/page.h */
@@ -0,0 +1,409 @@
+#include "vm/shm.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <string.h>
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/uaccess.h"
+
+/* Shared memory segments.
+
+   A segment is a named, zero-filled run of pages.  Each page has
+   one VM_SHM_PAGE supplemental page table entry of its own,
+   which belongs to no process: it owns the page's frame, and
+   that frame sits on the frame table and goes to swap like any
+   other, once for all of the processes that share it.
+
+   A process attaches a segment by giving each of its pages a
+   VM_SHM entry in the process's own table.  Faulting on one
+   brings in the segment's page if necessary and maps the same
+   frame into the process's page directory, adding the entry to
+   the page's list of mappers.  Evicting the frame unmaps it from
+   every mapper first.
+
+   A segment is reference counted: its creator holds a reference
+   until it exits and each attachment holds one until it is
+   detached.  The segment and its frames are freed, and its name
+   forgotten, when the last reference goes.
+
+   The same machinery shares pages copy-on-write after fork(); see
+   vm/cow.c.
+
+   All of this state is protected by page_lock. */
+
+/* A segment. */
+struct shm
+  {
+    char name[SHM_NAME_MAX + 1];
+    size_t page_cnt;
+    int ref_cnt;                /* Creator and attachments. */
+    struct shm_page *pages;     /* PAGE_CNT pages. */
+    struct list_elem elem;      /* Element in shm_list. */
+  };
+
+/* A process's reference to a segment, on its shm_list. */
+struct shm_ref
+  {
+    struct shm *shm;
+    void *addr;                 /* Where attached, or NULL for the
+                                   creator's reference. */
+    struct list_elem elem;
+  };
+
+static struct list shm_list;    /* All segments. */
+
+void
+shm_init(void)
+{
+  list_init(&shm_list);
+}
+
+/* Returns the segment named NAME, or NULL if there is none. */
+static struct shm *
+shm_find(const char *name)
+{
+  struct list_elem *e;
+  for(e = list_begin(&shm_list); e != list_end(&shm_list); e = list_next(e))
+  {
+      struct shm *shm = list_entry(e, struct shm, elem);
+      if(!strcmp(shm->name, name))
+        return shm;
+  }
+  return NULL;
+}
+
+/* Records a reference to SHM at ADDR for the current process.
+   Returns false if memory is short. */
+static bool
+shm_add_ref(struct shm *shm, void *addr)
+{
+  struct shm_ref *ref = malloc(sizeof *ref);
+  if(ref == NULL)
+    return false;
+  ref->shm = shm;
+  ref->addr = addr;
+  list_push_back(&thread_current()->shm_list, &ref->elem);
+  shm->ref_cnt++;
+  return true;
+}
+
+/* Drops a reference to SHM, freeing it and its frames if that
+   was the last. */
+static void
+shm_release(struct shm *shm)
+{
+  size_t i;
+
+  ASSERT(shm->ref_cnt > 0);
+  if(--shm->ref_cnt > 0)
+    return;
+
+  list_remove(&shm->elem);
+  for(i = 0; i < shm->page_cnt; i++)
+    shm_page_free(&shm->pages[i]);
+  free(shm->pages);
+  free(shm);
+}
+
+/* Creates a segment named NAME of SIZE bytes, rounded up to whole
+   pages, and gives the current process a reference to it that
+   lasts until it exits.  Returns false if a segment by that name
+   exists, SIZE is 0 or too large, or memory is short. */
+bool
+shm_create(const char *name, size_t size)
+{
+  size_t page_cnt = DIV_ROUND_UP(size, PGSIZE);
+  struct shm *shm;
+  size_t i;
+  bool success = false;
+
+  if(page_cnt == 0 || page_cnt > SHM_PAGES_MAX
+     || strlen(name) > SHM_NAME_MAX)
+    return false;
+
+  lock_acquire(&page_lock);
+  if(shm_find(name) != NULL)
+    goto done;
+  shm = malloc(sizeof *shm);
+  if(shm == NULL)
+    goto done;
+  shm->pages = malloc(page_cnt * sizeof *shm->pages);
+  if(shm->pages == NULL)
+  {
+      free(shm);
+      goto done;
+  }
+
+  strlcpy(shm->name, name, sizeof shm->name);
+  shm->page_cnt = page_cnt;
+  shm->ref_cnt = 0;
+  for(i = 0; i < page_cnt; i++)
+    shm_page_init(&shm->pages[i]);
+  list_push_back(&shm_list, &shm->elem);
+  success = shm_add_ref(shm, NULL);
+  if(!success)
+    shm_release(shm);
+
+ done:
+  lock_release(&page_lock);
+  return success;
+}
+
+/* Removes the current process's VM_SHM entries for the CNT pages
+   starting at ADDR. */
+static void
+shm_remove_pages(void *addr, size_t cnt)
+{
+  size_t i;
+  for(i = 0; i < cnt; i++)
+  {
+      struct SPT_elem *elem = vm_lookup_page((uint8_t *)addr + i * PGSIZE);
+      if(elem != NULL)
+      {
+          ASSERT(elem->type == VM_SHM);
+          frame_destroy(elem);
+      }
+  }
+}
+
+/* Attaches SHM to the current process at ADDR.  page_lock must
+   be held. */
+static bool
+shm_map_segment(struct shm *shm, void *addr)
+{
+  struct thread *t = thread_current();
+  size_t i;
+
+  if(!is_user_range(addr, shm->page_cnt * PGSIZE))
+    return false;
+  for(i = 0; i < shm->page_cnt; i++)
+  {
+      void *upage = (uint8_t *)addr + i * PGSIZE;
+      if(pagedir_get_page(t->pagedir, upage) != NULL
+         || vm_lookup_page(upage) != NULL)
+        return false;
+  }
+
+  for(i = 0; i < shm->page_cnt; i++)
+  {
+      void *upage = (uint8_t *)addr + i * PGSIZE;
+      struct shm_map *map = malloc(sizeof *map);
+      if(map == NULL || !palloc_user_page(upage, VM_SHM, map))
+      {
+          free(map);
+          shm_remove_pages(addr, i);
+          return false;
+      }
+      map->page = &shm->pages[i];
+      map->owner = t;
+      map->writable = true;
+      map->mapped = false;
+  }
+  if(!shm_add_ref(shm, addr))
+  {
+      shm_remove_pages(addr, shm->page_cnt);
+      return false;
+  }
+  return true;
+}
+
+/* Attaches the segment named NAME to the current process at
+   ADDR, which must be page-aligned, with room below PHYS_BASE for
+   the whole segment and no pages in use there.  Pages are mapped
+   lazily, when first touched.  Returns true if successful. */
+bool
+shm_attach(const char *name, void *addr)
+{
+  struct shm *shm;
+  bool success = false;
+
+  if(addr == NULL || pg_ofs(addr) != 0)
+    return false;
+
+  lock_acquire(&page_lock);
+  shm = shm_find(name);
+  if(shm != NULL)
+    success = shm_map_segment(shm, addr);
+  lock_release(&page_lock);
+  return success;
+}
+
+/* Detaches the segment the current process attached at ADDR.
+   Returns false if there is none. */
+bool
+shm_detach(void *addr)
+{
+  struct list *shm_list_ = &thread_current()->shm_list;
+  struct list_elem *e;
+  bool success = false;
+
+  if(addr == NULL)
+    return false;
+
+  lock_acquire(&page_lock);
+  for(e = list_begin(shm_list_); e != list_end(shm_list_); e = list_next(e))
+  {
+      struct shm_ref *ref = list_entry(e, struct shm_ref, elem);
+      if(ref->addr == addr)
+      {
+          shm_remove_pages(addr, ref->shm->page_cnt);
+          list_remove(&ref->elem);
+          shm_release(ref->shm);
+          free(ref);
+          success = true;
+          break;
+      }
+  }
+  lock_release(&page_lock);
+  return success;
+}
+
+/* Drops every segment reference of the current process, which is
+   exiting and has already destroyed its page table entries.
+   page_lock must be held. */
+void
+shm_exit(void)
+{
+  struct list *shm_list_ = &thread_current()->shm_list;
+  while(!list_empty(shm_list_))
+  {
+      struct shm_ref *ref = list_entry(list_pop_front(shm_list_), struct shm_ref, elem);
+      shm_release(ref->shm);
+      free(ref);
+  }
+}
+
+/* Gives the current process, a child just forked from PARENT,
+   the segments PARENT has attached, at the same addresses.  The
+   creator's references are not inherited.  Returns false if
+   memory is short. */
+bool
+shm_fork(struct thread *parent)
+{
+  struct list_elem *e;
+  bool success = true;
+
+  lock_acquire(&page_lock);
+  for(e = list_begin(&parent->shm_list);
+      success && e != list_end(&parent->shm_list); e = list_next(e))
+  {
+      struct shm_ref *ref = list_entry(e, struct shm_ref, elem);
+      if(ref->addr != NULL)
+        success = shm_map_segment(ref->shm, ref->addr);
+  }
+  lock_release(&page_lock);
+  return success;
+}
+
+/* Initializes PAGE as a shared page with no contents yet.  It is
+   zero-filled when first brought in. */
+void
+shm_page_init(struct shm_page *page)
+{
+  page->spt.vaddr = NULL;
+  page->spt.type = VM_SHM_PAGE;
+  page->spt.aux = NULL;
+  page->spt.paddr = NULL;
+  page->spt.frame_ptr = NULL;
+  list_init(&page->mappers);
+}
+
+/* Frees the frame and swap space held by PAGE, which no process
+   has mapped any longer.  page_lock must be held. */
+void
+shm_page_free(struct shm_page *page)
+{
+  struct SPT_elem *spt = &page->spt;
+
+  ASSERT(list_empty(&page->mappers));
+  if(spt->frame_ptr != NULL)
+  {
+      swap_release(spt->frame_ptr);
+      list_remove(&spt->frame_ptr->elem);
+      slab_free(&frame_cache, spt->frame_ptr);
+  }
+  if(spt->paddr != NULL)
+    palloc_free_page(spt->paddr);
+}
+
+/* Returns the VM_SHM_PAGE entry that owns the frame behind ELEM,
+   a process's VM_SHM or VM_COW entry. */
+struct SPT_elem *
+shm_backing(struct SPT_elem *elem)
+{
+  struct shm_map *map = elem->aux;
+  ASSERT(elem->type == VM_SHM || elem->type == VM_COW);
+  return &map->page->spt;
+}
+
+/* Maps the shared page behind ELEM, a process's VM_SHM or VM_COW
+   entry, bringing it into memory first if need be.  page_lock
+   must be held. */
+bool
+shm_install(struct SPT_elem *elem)
+{
+  struct shm_map *map = elem->aux;
+  struct SPT_elem *page = &map->page->spt;
+
+  ASSERT(elem->type == VM_SHM || elem->type == VM_COW);
+  if(page->paddr == NULL && !vm_install(page))
+    return false;
+  elem->paddr = page->paddr;
+  if(!vm_install_page(elem, map->writable))
+  {
+      elem->paddr = NULL;
+      return false;
+  }
+  if(!map->mapped)
+  {
+      list_push_back(&map->page->mappers, &elem->mmap_elem);
+      map->mapped = true;
+  }
+  return true;
+}
+
+/* Unmaps ELEM, a process's VM_SHM or VM_COW entry, from its
+   process.  The frame stays with the shared page. */
+void
+shm_unmap(struct SPT_elem *elem)
+{
+  struct shm_map *map = elem->aux;
+
+  ASSERT(elem->type == VM_SHM || elem->type == VM_COW);
+  if(map->mapped)
+  {
+      list_remove(&elem->mmap_elem);
+      map->mapped = false;
+  }
+  if(elem->paddr != NULL)
+  {
+      pagedir_clear_page(map->owner->pagedir, elem->vaddr);
+      elem->paddr = NULL;
+  }
+}
+
+/* Unmaps shared page PAGE, a VM_SHM_PAGE entry whose frame is
+   being evicted, from every process that has it mapped. */
+void
+shm_unmap_all(struct SPT_elem *page)
+{
+  struct shm_page *sp = (struct shm_page *)page;
+
+  ASSERT(page->type == VM_SHM_PAGE);
+  while(!list_empty(&sp->mappers))
+  {
+      struct SPT_elem *elem = list_entry(list_pop_front(&sp->mappers),
+                                         struct SPT_elem, mmap_elem);
+      struct shm_map *map = elem->aux;
+      pagedir_clear_page(map->owner->pagedir, elem->vaddr);
+      elem->paddr = NULL;
+      map->mapped = false;
+  }
+}
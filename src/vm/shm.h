@@ -0,0 +1,45 @@
+#ifndef SHM_H
+#define SHM_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <list.h>
+#include "vm/page.h"
+
+struct thread;
+
+/* Shared memory segments. */
+#define SHM_NAME_MAX 14         /* Longest segment name. */
+#define SHM_PAGES_MAX 128       /* Largest segment, in pages. */
+
+/* A page shared by several processes: a shared memory segment's
+   page, or a page shared copy-on-write after fork().  */
+struct shm_page
+  {
+    struct SPT_elem spt;        /* VM_SHM_PAGE entry; must be first. */
+    struct list mappers;        /* Mapped entries, via mmap_elem. */
+  };
+
+/* The aux of a process's VM_SHM or VM_COW entry. */
+struct shm_map
+  {
+    struct shm_page *page;      /* Page it maps. */
+    struct thread *owner;       /* Process it belongs to. */
+    bool writable;              /* Map the page writable? */
+    bool mapped;                /* On PAGE's mappers list? */
+  };
+
+void shm_init(void);
+bool shm_create(const char *name, size_t size);
+bool shm_attach(const char *name, void *addr);
+bool shm_detach(void *addr);
+void shm_exit(void);
+bool shm_fork(struct thread *parent);
+
+void shm_page_init(struct shm_page *);
+void shm_page_free(struct shm_page *);
+
+bool shm_install(struct SPT_elem *);
+void shm_unmap(struct SPT_elem *);
+void shm_unmap_all(struct SPT_elem *);
+struct SPT_elem *shm_backing(struct SPT_elem *);
+#endif /* vm/shm.h */
@@ -1,13 +1,226 @@
 #include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
 #include "vm/swap.h"
 #include "vm/frame.h"
 #include "vm/page.h"
+#include "vm/shm.h"
 #include "devices/disk.h"
 #include "userprog/pagedir.h"
 #include "threads/thread.h"
 #include "threads/palloc.h"
 #include "threads/interrupt.h"
+#include "threads/vaddr.h"
 #include <debug.h>
+#include <round.h>
+
+/* Compressed swap tier.
+
+   Evicted pages are first offered to an in-memory arena carved
+   out of the kernel pool.  Pages whose words are all the same
+   (zeroed stacks, memset buffers) take no arena space at all;
+   other pages are run-length encoded a word at a time and kept
+   if they shrink below ZSWAP_MAX_LEN.  Only pages the tier
+   rejects, or that no longer fit, are written to swap_disk.
+
+   All of this state is protected by page_lock, which every
+   caller of swap_in() and swap_out() already holds. */
+#define ZSWAP_CHUNK 64                          /* Arena allocation unit. */
+#define ZSWAP_MAX_LEN (PGSIZE * 3 / 4)          /* Larger results go to disk. */
+#define PAGE_WORDS (PGSIZE / sizeof(uint32_t))
+
+/* Token header bit: the token is a run of one repeated word
+   rather than a block of literal words. */
+#define ZTOK_RUN 0x8000
+
+size_t zswap_pages;
+static uint8_t *zswap_arena;
+static struct bitmap *zswap_map;        /* One bit per chunk. */
+static uint8_t *zswap_scratch;          /* Compression output. */
+
+/* Statistics. */
+static long long zswap_stores;          /* Pages kept in the tier. */
+static long long zswap_same_filled;     /* ...of which same-filled. */
+static long long zswap_rejects;         /* Incompressible pages. */
+static long long zswap_spills;          /* Compressible, but arena full. */
+static long long zswap_hits;            /* swap_in() served from the tier. */
+static long long zswap_disk_ins;        /* swap_in() served from disk. */
+static long long zswap_bytes_in;        /* Uncompressed bytes stored. */
+static long long zswap_bytes_out;       /* Compressed bytes stored. */
+
+void
+swap_init(void)
+{
+  swap_disk = disk_get(1,1); // swap disk
+  free_space = bitmap_create(disk_size(swap_disk) >> 3);
+
+  if(zswap_pages == 0)
+    return;
+  zswap_arena = palloc_get_multiple(0, zswap_pages);
+  zswap_scratch = palloc_get_page(0);
+  zswap_map = bitmap_create(zswap_pages * (PGSIZE / ZSWAP_CHUNK));
+  if(zswap_arena == NULL || zswap_scratch == NULL || zswap_map == NULL)
+    PANIC("zswap: cannot reserve %zu pages", zswap_pages);
+}
+
+/* Returns true if every word of PAGE equals its first word. */
+static bool
+page_same_filled(const uint32_t *page)
+{
+  size_t i;
+  for(i = 1; i < PAGE_WORDS; i++)
+    if(page[i] != page[0])
+      return false;
+  return true;
+}
+
+/* Encodes PAGE into DST as a sequence of tokens.  Each token is
+   a uint16_t header holding a word count, followed either by one
+   word repeated that many times (ZTOK_RUN set) or by that many
+   literal words.  Returns the encoded length, or 0 as soon as it
+   would exceed ZSWAP_MAX_LEN. */
+static size_t
+zswap_compress(const uint32_t *page, uint8_t *dst)
+{
+  size_t len = 0;
+  size_t i = 0;
+  while(i < PAGE_WORDS)
+  {
+      size_t run = 1;
+      while(i + run < PAGE_WORDS && page[i + run] == page[i])
+        run++;
+
+      if(run >= 3)
+      {
+          uint16_t hdr = ZTOK_RUN | run;
+          if(len + sizeof hdr + sizeof *page > ZSWAP_MAX_LEN)
+            return 0;
+          memcpy(dst + len, &hdr, sizeof hdr);
+          memcpy(dst + len + sizeof hdr, &page[i], sizeof *page);
+          len += sizeof hdr + sizeof *page;
+          i += run;
+      }
+      else
+      {
+          /* Collect literals up to the start of the next run. */
+          size_t start = i;
+          uint16_t hdr;
+          while(i < PAGE_WORDS
+                && !(i + 2 < PAGE_WORDS && page[i] == page[i + 1]
+                     && page[i] == page[i + 2]))
+            i++;
+          hdr = i - start;
+          if(len + sizeof hdr + hdr * sizeof *page > ZSWAP_MAX_LEN)
+            return 0;
+          memcpy(dst + len, &hdr, sizeof hdr);
+          memcpy(dst + len + sizeof hdr, &page[start], hdr * sizeof *page);
+          len += sizeof hdr + hdr * sizeof *page;
+      }
+  }
+  return len;
+}
+
+/* Decodes LEN bytes produced by zswap_compress() from SRC into
+   the page at PAGE. */
+static void
+zswap_decompress(const uint8_t *src, size_t len, uint32_t *page)
+{
+  const uint8_t *end = src + len;
+  size_t i = 0;
+  while(src < end)
+  {
+      uint16_t hdr;
+      size_t cnt;
+      memcpy(&hdr, src, sizeof hdr);
+      src += sizeof hdr;
+      cnt = hdr & ~ZTOK_RUN;
+      ASSERT(i + cnt <= PAGE_WORDS);
+      if(hdr & ZTOK_RUN)
+      {
+          uint32_t word;
+          memcpy(&word, src, sizeof word);
+          src += sizeof word;
+          while(cnt-- > 0)
+            page[i++] = word;
+      }
+      else
+      {
+          memcpy(&page[i], src, cnt * sizeof *page);
+          src += cnt * sizeof *page;
+          i += cnt;
+      }
+  }
+  ASSERT(i == PAGE_WORDS);
+}
+
+/* Tries to keep the contents of PADDR, which belongs to FELEM,
+   in the compressed tier.  Returns false if the tier is disabled,
+   the page does not compress well or the arena is full. */
+static bool
+zswap_store(struct FRAME_elem *felem, const void *paddr)
+{
+  size_t len, idx;
+
+  if(zswap_arena == NULL)
+    return false;
+
+  if(page_same_filled(paddr))
+  {
+      felem->zlen = 0;
+      felem->zfill = *(const uint32_t *)paddr;
+      zswap_stores++;
+      zswap_same_filled++;
+      zswap_bytes_in += PGSIZE;
+      return true;
+  }
+
+  len = zswap_compress(paddr, zswap_scratch);
+  if(len == 0)
+  {
+      zswap_rejects++;
+      return false;
+  }
+
+  idx = bitmap_scan_and_flip_next(zswap_map, DIV_ROUND_UP(len, ZSWAP_CHUNK), false);
+  if(idx == BITMAP_ERROR)
+  {
+      zswap_spills++;
+      return false;
+  }
+  memcpy(zswap_arena + idx * ZSWAP_CHUNK, zswap_scratch, len);
+  felem->start = idx;
+  felem->zlen = len;
+  zswap_stores++;
+  zswap_bytes_in += PGSIZE;
+  zswap_bytes_out += len;
+  return true;
+}
+
+/* Fills PADDR with the page FELEM holds in the compressed tier. */
+static void
+zswap_load(struct FRAME_elem *felem, void *paddr)
+{
+  if(felem->zlen == 0)
+  {
+      uint32_t *page = paddr;
+      size_t i;
+      for(i = 0; i < PAGE_WORDS; i++)
+        page[i] = felem->zfill;
+  }
+  else
+    zswap_decompress(zswap_arena + felem->start * ZSWAP_CHUNK, felem->zlen, paddr);
+}
+
+/* Releases the swap slot or compressed copy held by FELEM. */
+void
+swap_release(struct FRAME_elem *felem)
+{
+  if(felem->swaped == DISK)
+    bitmap_set_multiple(free_space, felem->start, 1, false);
+  else if(felem->swaped == ZSWAP && felem->zlen != 0)
+    bitmap_set_multiple(zswap_map, felem->start,
+                        DIV_ROUND_UP(felem->zlen, ZSWAP_CHUNK), false);
+}
 
 // get page from swap disk
 bool
@@ -16,25 +229,34 @@ swap_in(struct SPT_elem *elem)
   struct list_elem *e;
   struct FRAME_elem *felem;
   uint8_t *new_page;
-  int i;
   bool writable;
   for(e = list_begin(&swap_list); e != list_end(&swap_list); e = list_next(e))
   {
       felem = list_entry(e, struct FRAME_elem, elem);
       if(felem == elem->frame_ptr)
       {
-          ASSERT(felem->swaped == DISK);
+          ASSERT(felem->swaped == DISK || felem->swaped == ZSWAP);
           new_page = palloc_get_page(PAL_USER);
           if(new_page == NULL)
           {
               return swap_out(elem);
           }
           elem->paddr = new_page;
-          for(i = 0; i < 8; i++)
-              disk_read(swap_disk, (felem->start << 3) + i, elem->paddr + DISK_SECTOR_SIZE * i);
+          if(felem->swaped == ZSWAP)
+          {
+              zswap_load(felem, elem->paddr);
+              zswap_hits++;
+          }
+          else
+          {
+              disk_read_multiple(swap_disk, felem->start << 3, elem->paddr, 8);
+              zswap_disk_ins++;
+          }
           writable = (elem->type == VM_SEGMENT) ? (bool)((int32_t *)elem->aux)[2] : true;
-          bitmap_set_multiple(free_space, felem->start, 1, false);
+          swap_release(felem);
           list_remove(&felem->elem);
+          if(elem->type == VM_SHM_PAGE)
+            return true;
           return vm_install_page(elem, writable);
       }
   }
@@ -46,31 +268,66 @@ bool
 swap_out(struct SPT_elem *elem)
 {
   ASSERT(!list_empty(&FT));
-  
-  struct list_elem *e = list_pop_front(&FT);
-  struct FRAME_elem *felem = list_entry(e, struct FRAME_elem, elem);
+
+  /* Evict the oldest frame that is not pinned for I/O. */
+  struct list_elem *e;
+  struct FRAME_elem *felem = NULL;
+  for(e = list_begin(&FT); e != list_end(&FT); e = list_next(e))
+  {
+      felem = list_entry(e, struct FRAME_elem, elem);
+      if(felem->pin_cnt == 0)
+        break;
+  }
+  if(e == list_end(&FT)) PANIC("KERNEL PANIC DUE TO ALL FRAMES PINNED");
+  list_remove(e);
 
   size_t swap_idx;
-  int i;
 
   //printf("swap out: %d's %x %x\n", felem->holder->tid, felem->SPT_ptr->vaddr, felem->SPT_ptr->paddr);
   ASSERT(felem->swaped == MEMORY);
   // if mmaped, rewrite to it
   write_back(felem->SPT_ptr);
-  pagedir_clear_page(felem->holder->pagedir, felem->SPT_ptr->vaddr);
-  
-  swap_idx = bitmap_scan_and_flip(free_space, 0, 1, false);
-  if(swap_idx == BITMAP_ERROR) PANIC("KERNEL PANIC DUE TO FULL SWAP DISK");
+  if(felem->SPT_ptr->type == VM_SHM_PAGE)
+    shm_unmap_all(felem->SPT_ptr);
+  else
+    pagedir_clear_page(felem->holder->pagedir, felem->SPT_ptr->vaddr);
 
-  felem->swaped = DISK;
-  felem->start = swap_idx;
   void *paddr = felem->SPT_ptr->paddr;
-  for(i = 0; i < 8; i++)
-      disk_write(swap_disk, (felem->start << 3) + i, paddr + DISK_SECTOR_SIZE * i);
-  
+  if(zswap_store(felem, paddr))
+  {
+      felem->swaped = ZSWAP;
+  }
+  else
+  {
+      swap_idx = bitmap_scan_and_flip_next(free_space, 1, false);
+      if(swap_idx == BITMAP_ERROR) PANIC("KERNEL PANIC DUE TO FULL SWAP DISK");
+
+      felem->swaped = DISK;
+      felem->start = swap_idx;
+      disk_write_multiple(swap_disk, felem->start << 3, paddr, 8);
+  }
+
   // free page
   felem->SPT_ptr->paddr = NULL;
   palloc_free_page(paddr);
   list_push_front(&swap_list, &felem->elem);
   return vm_install(elem);
 }
+
+/* Prints compressed swap tier statistics. */
+void
+swap_print_stats(void)
+{
+  long long lookups = zswap_hits + zswap_disk_ins;
+
+  if(zswap_arena == NULL)
+    return;
+  printf("Zswap: %lld pages stored (%lld same-filled), %lld rejected, "
+         "%lld spilled to disk\n",
+         zswap_stores, zswap_same_filled, zswap_rejects, zswap_spills);
+  printf("Zswap: %lld bytes compressed to %lld (%lld%%), "
+         "%lld of %lld swap-ins hit (%lld%%)\n",
+         zswap_bytes_in, zswap_bytes_out,
+         zswap_bytes_in ? zswap_bytes_out * 100 / zswap_bytes_in : 0,
+         zswap_hits, lookups, lookups ? zswap_hits * 100 / lookups : 0);
+}
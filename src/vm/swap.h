@@ -7,12 +7,21 @@
 
 struct SPT_elem;
 
-typedef enum {NA, DISK, MEMORY} swap_state;
+typedef enum {NA, DISK, MEMORY, ZSWAP} swap_state;
 
 struct disk *swap_disk;
 struct bitmap *free_space;
 struct lock swap_lock;
 
+/* Pages reserved for the compressed swap tier (-zswap=PAGES).
+   0 disables the tier and every eviction goes to swap_disk. */
+extern size_t zswap_pages;
+
+struct FRAME_elem;
+
+void swap_init(void);
 bool swap_in(struct SPT_elem *);
 bool swap_out(struct SPT_elem *);
+void swap_release(struct FRAME_elem *);
+void swap_print_stats(void);
 #endif /* vm/swap.h */